@@ -40,6 +40,7 @@ define EMBED_RULES # 1=middir 2=platform
   $1/data/embed/%.map.c:src/data/embed/%.map $(EXE_TOOL_map);$$(PRECMD) $(EXE_TOOL_map) -o$$@ $$< --platform=$2
   $1/data/embed/%.mid.c:src/data/embed/%.mid $(EXE_TOOL_songcvt);$$(PRECMD) $(EXE_TOOL_songcvt) -o$$@ $$< --platform=$2
   $1/data/embed/%.wave.c:src/data/embed/%.wave $(EXE_TOOL_wavecvt);$$(PRECMD) $(EXE_TOOL_wavecvt) -o$$@ $$< --platform=$2
+  $1/data/embed/%.puzzles.c:src/data/embed/%.puzzles $(EXE_TOOL_puzzlecvt);$$(PRECMD) $(EXE_TOOL_puzzlecvt) -o$$@ $$< --platform=$2
   $1/data/embed/%.c:src/data/embed/% $(EXE_TOOL_rawcvt);$$(PRECMD) $(EXE_TOOL_rawcvt) -o$$@ $$< --platform=$2
   .precious:$$(EMBED_CFILES_$1)
 endef
@@ -79,6 +80,8 @@ define TOOL_OPT # 1=tool 2=optunits
 endef
 $(foreach U,$(TOOLS),$(eval $(call TOOL_RULES,$U)))
 $(eval $(call TOOL_OPT,audioedit,pulse inotify alsamidi))
+# sufuzz also tests the game's board bookkeeping and undo journal, which are plain C with no platform behind them.
+$(EXE_TOOL_sufuzz):$(MIDDIR)/main/board.o $(MIDDIR)/main/journal.o
 
 # Native game executable is optional, maybe you're only building for Tiny.
 ifneq (,$(strip $(EXE_NATIVE)))
@@ -14,8 +14,26 @@ else
   launch:;echo "TINY_BIN_SOLO unset" ; exit 1
 endif
 
+# Generator benchmark. `make bench` fails if we got slower than the baseline, which is tracked so `make clean` can't lose it.
+# Timings depend on the machine: After changing machines, or a deliberate speedup, rerun `make bench-baseline` and commit the result.
+BENCH_REPORT:=out/bench.json
+BENCH_BASELINE:=etc/bench-baseline.json
+bench:$(EXE_TOOL_subench);$(EXE_TOOL_subench) -o$(BENCH_REPORT) --baseline=$(BENCH_BASELINE)
+bench-baseline:$(EXE_TOOL_subench);$(EXE_TOOL_subench) -o$(BENCH_BASELINE)
+
+# Differential tests: Generator and every solver backend, cross-checked on random seeds and edited puzzles.
+# Also the game's conflict tracking, notes, and undo journal, under random moves.
+# `make fuzz` builds the same checks into a libFuzzer binary (needs clang) and runs it until you stop it.
+TEST_COUNT:=2000
+test:$(EXE_TOOL_sufuzz);$(EXE_TOOL_sufuzz) --count=$(TEST_COUNT) --seed=1
+FUZZ_EXE:=out/fuzz/sufuzz
+FUZZ_CORPUS:=out/fuzz/corpus
+FUZZ_CC:=clang -O1 -g -fsanitize=fuzzer,address,undefined -Isrc -Isrc/common -DBC_PLATFORM=BC_PLATFORM_$(BC_PLATFORM) -DSUFUZZ_LIBFUZZER
+$(FUZZ_EXE):src/tool/sufuzz/sufuzz_case.c src/tool/sufuzz/sufuzz_game.c src/main/board.c src/main/journal.c $(filter src/common/su_%.c,$(CFILES));$(PRECMD) $(FUZZ_CC) -o$@ $^ -lpthread
+fuzz:$(FUZZ_EXE);mkdir -p $(FUZZ_CORPUS) ; $(FUZZ_EXE) $(FUZZ_CORPUS)
+
 edit-audio:$(EXE_TOOL_audioedit) $(EXE_TOOL_sounds) $(EXE_TOOL_wavecvt);$(EXE_TOOL_audioedit)
 
-deploy-menu sdcard test install help:;echo "TODO: make $@" ; exit 1
+deploy-menu sdcard install help:;echo "TODO: make $@" ; exit 1
 
 clean:;rm -rf mid out
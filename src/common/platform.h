@@ -64,6 +64,13 @@ void platform_send_framebuffer(const void *fb);
 uint32_t millis();
 uint32_t micros();
 
+/* Persistent storage: The SD card on the Tiny, a directory under XDG data on Linux.
+ * Read up to (dsta) bytes from (seek) on. Returns the length read, or <0 if the file can't be opened.
+ * Write (srcc) bytes at (seek), creating the file if needed and zero-filling any gap. Returns <0 on error.
+ */
+int32_t ma_file_read(void *dst,int32_t dsta,const char *path,int32_t seek);
+int32_t ma_file_write(const char *path,const void *src,int32_t srcc,int32_t seek);
+
 /* Implemented generically.
  *******************************************************************/
  
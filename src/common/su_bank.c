@@ -0,0 +1,97 @@
+#include "sudoku.h"
+#include <string.h>
+
+/* Permutation rank of one row, 0..362879.
+ */
+
+static const uint32_t su_factorialv[9]={1,1,2,6,24,120,720,5040,40320};
+
+static uint32_t su_bank_rank_row(const uint8_t *row) {
+  uint32_t rank=0;
+  uint16_t avail=SU_ALL;
+  uint8_t i=0; for (;i<9;i++) {
+    uint16_t bit=1<<(row[i]-1);
+    rank+=su_popcount(avail&(bit-1))*su_factorialv[8-i];
+    avail&=~bit;
+  }
+  return rank;
+}
+
+static void su_bank_unrank_row(uint8_t *row,uint32_t rank) {
+  uint16_t avail=SU_ALL;
+  uint8_t i=0; for (;i<9;i++) {
+    uint8_t k=rank/su_factorialv[8-i];
+    rank%=su_factorialv[8-i];
+    uint16_t mask=avail;
+    while (k--) mask&=mask-1;
+    mask&=-mask;
+    row[i]=su_mask_digit(mask);
+    avail&=~mask;
+  }
+}
+
+/* Encode record.
+ */
+
+void su_bank_encode(uint8_t *dst,const uint16_t *field) {
+  memset(dst,0,SU_BANK_RECORD_SIZE);
+  uint8_t p=0; for (;p<81;p++) {
+    if (field[p]&0x0200) dst[p>>3]|=0x80>>(p&7);
+  }
+  uint8_t *bits=dst+11;
+  uint8_t bitp=0,row=0;
+  for (;row<8;row++) {
+    uint8_t digits[9],col=0;
+    for (;col<9;col++) digits[col]=(field[row*9+col]>>4)&15;
+    uint32_t rank=su_bank_rank_row(digits);
+    uint8_t i=19; while (i-->0) {
+      if (rank&(1<<i)) bits[bitp>>3]|=0x80>>(bitp&7);
+      bitp++;
+    }
+  }
+}
+
+/* Decode record.
+ */
+
+void su_bank_decode(uint16_t *field,const uint8_t *src) {
+  uint8_t value[81];
+  const uint8_t *bits=src+11;
+  uint8_t bitp=0,row=0;
+  for (;row<8;row++) {
+    uint32_t rank=0;
+    uint8_t i=19; while (i-->0) {
+      rank<<=1;
+      if (bits[bitp>>3]&(0x80>>(bitp&7))) rank|=1;
+      bitp++;
+    }
+    su_bank_unrank_row(value+row*9,rank);
+  }
+  uint8_t col=0; for (;col<9;col++) {
+    uint8_t sum=45;
+    for (row=0;row<8;row++) sum-=value[row*9+col];
+    value[72+col]=sum;
+  }
+  uint8_t p=0; for (;p<81;p++) {
+    if (src[p>>3]&(0x80>>(p&7))) field[p]=0x0300|(value[p]<<4)|value[p];
+    else field[p]=value[p]<<4;
+  }
+}
+
+/* Bank access.
+ */
+
+uint16_t su_bank_count(const uint8_t *bank,uint32_t bankc,uint8_t tier) {
+  if (tier>=SU_TIER_COUNT) return 0;
+  if (bankc<SU_BANK_HEADER_SIZE) return 0;
+  return (bank[tier<<1]<<8)|bank[(tier<<1)+1];
+}
+
+const uint8_t *su_bank_get(const uint8_t *bank,uint32_t bankc,uint8_t tier,uint16_t index) {
+  if (index>=su_bank_count(bank,bankc,tier)) return 0;
+  uint32_t recordp=index;
+  uint8_t i=0; for (;i<tier;i++) recordp+=su_bank_count(bank,bankc,i);
+  uint32_t p=SU_BANK_HEADER_SIZE+recordp*SU_BANK_RECORD_SIZE;
+  if (p+SU_BANK_RECORD_SIZE>bankc) return 0;
+  return bank+p;
+}
@@ -0,0 +1,205 @@
+#include "platform.h"
+#include "sudoku.h"
+#include <string.h>
+
+#if BC_PLATFORM!=BC_PLATFORM_tiny
+  #include <stdlib.h>
+#endif
+
+/* Search context.
+ * The canonical form is the lexicographically least grid we can reach, with digits relabeled in order of first appearance.
+ * For each orientation and each choice of first row, we choose columns one at a time, then the remaining rows one at a time,
+ * abandoning a branch as soon as its output is worse than the best so far.
+ * Whenever a branch beats the best, the best's unwritten tail is set to 0xff, so the first completion below it always wins.
+ * Relabeling depends on what came before, so a tie can't be settled locally; we descend into each.
+ * For a puzzle, most branches die within the first row, since a blank there sorts ahead of any clue.
+ * A full grid is the worst case: Its first row relabels to 123456789 whatever the column order,
+ * so all 1296 orders tie for each of the 18 first rows and go on to the rows. That's about ten times the work.
+ */
+
+struct su_canon_search {
+  uint8_t grid[81]; // Source, possibly transposed.
+  uint8_t colv[9]; // Source column for each output column.
+  uint8_t rowv[9]; // Source row for each output row, as far as we've gone.
+  uint8_t best[81];
+};
+
+/* Compare one output cell against (best), and take it if it's better.
+ * Returns >0 to abandon the branch.
+ */
+
+static inline int8_t su_canon_cell(struct su_canon_search *search,uint8_t p,uint8_t label) {
+  if (label>search->best[p]) return 1;
+  if (label<search->best[p]) {
+    search->best[p]=label;
+    memset(search->best+p+1,0xff,80-p);
+  }
+  return 0;
+}
+
+/* Choose output row (r) and everything below it. Columns are settled.
+ * (map) relabels source digits, map[0] is always 0. (labelc) is the highest label assigned so far.
+ * Label every eligible row first, and descend only into the least, so we don't wander down branches a later sibling would beat.
+ */
+
+static void su_canon_rows(struct su_canon_search *search,uint8_t r,uint16_t usedrows,const uint8_t *map,uint8_t labelc) {
+  if (r>=9) return;
+  uint8_t lo=0,hi=9;
+  if (r%3) {
+    lo=(search->rowv[r-1]/3)*3;
+    hi=lo+3;
+  }
+  uint8_t rowv[9][9],mapv[9][10],labelcv[9],srcv[9],candc=0,leastp=0;
+  uint8_t src=lo;
+  for (;src<hi;src++) {
+    if (usedrows&(1<<src)) continue;
+    if (!(r%3)&&(usedrows&(7<<((src/3)*3)))) continue; // Starting a band, and this one's taken.
+    uint8_t *row=rowv[candc],*submap=mapv[candc];
+    memcpy(submap,map,10);
+    labelcv[candc]=labelc;
+    const uint8_t *srcrow=search->grid+src*9;
+    uint8_t i=0; for (;i<9;i++) {
+      uint8_t digit=srcrow[search->colv[i]];
+      if (digit&&!submap[digit]) submap[digit]=++(labelcv[candc]);
+      row[i]=submap[digit];
+    }
+    srcv[candc]=src;
+    if (candc&&(memcmp(row,rowv[leastp],9)<0)) leastp=candc;
+    candc++;
+  }
+  if (!candc) return;
+  
+  uint8_t *best=search->best+r*9;
+  int cmp=memcmp(rowv[leastp],best,9);
+  if (cmp>0) return;
+  if (cmp<0) {
+    memcpy(best,rowv[leastp],9);
+    memset(best+9,0xff,72-r*9);
+  }
+  uint8_t i=0; for (;i<candc;i++) {
+    if ((i!=leastp)&&memcmp(rowv[i],rowv[leastp],9)) continue;
+    search->rowv[r]=srcv[i];
+    su_canon_rows(search,r+1,usedrows|(1<<srcv[i]),mapv[i],labelcv[i]);
+  }
+}
+
+/* Choose output column (c) and everything right of it, with the first row fixed.
+ * Same idea as rows, one cell at a time.
+ */
+
+static void su_canon_columns(struct su_canon_search *search,uint8_t c,uint16_t usedcols,const uint8_t *map,uint8_t labelc) {
+  if (c>=9) {
+    su_canon_rows(search,1,1<<search->rowv[0],map,labelc);
+    return;
+  }
+  uint8_t lo=0,hi=9;
+  if (c%3) {
+    lo=(search->colv[c-1]/3)*3;
+    hi=lo+3;
+  }
+  const uint8_t *srcrow=search->grid+search->rowv[0]*9;
+  uint8_t labelv[9],least=0xff;
+  uint8_t src=lo;
+  for (;src<hi;src++) {
+    labelv[src]=0xff;
+    if (usedcols&(1<<src)) continue;
+    if (!(c%3)&&(usedcols&(7<<((src/3)*3)))) continue; // Starting a stack, and this one's taken.
+    uint8_t digit=srcrow[src];
+    labelv[src]=digit?(map[digit]?map[digit]:(labelc+1)):0;
+    if (labelv[src]<least) least=labelv[src];
+  }
+  if (least==0xff) return;
+  if (su_canon_cell(search,c,least)) return;
+  for (src=lo;src<hi;src++) {
+    if (labelv[src]!=least) continue;
+    uint8_t submap[10];
+    memcpy(submap,map,10);
+    uint8_t digit=srcrow[src];
+    search->colv[c]=src;
+    if (digit&&!submap[digit]) {
+      submap[digit]=labelc+1;
+      su_canon_columns(search,c+1,usedcols|(1<<src),submap,labelc+1);
+    } else {
+      su_canon_columns(search,c+1,usedcols|(1<<src),submap,labelc);
+    }
+  }
+}
+
+/* Canonical form, main entry points.
+ */
+
+void su_canon(uint8_t *dst,const uint8_t *src) {
+  struct su_canon_search search;
+  memset(search.best,0xff,81);
+  const uint8_t map[10]={0};
+  uint8_t transpose=0; for (;transpose<2;transpose++) {
+    if (transpose) {
+      uint8_t p=0; for (;p<81;p++) search.grid[p]=src[(p%9)*9+p/9];
+    } else {
+      memcpy(search.grid,src,81);
+    }
+    uint8_t row=0; for (;row<9;row++) {
+      search.rowv[0]=row;
+      su_canon_columns(&search,0,0,map,0);
+    }
+  }
+  memcpy(dst,search.best,81);
+}
+
+void su_canon_field(uint8_t *dst,const uint16_t *field) {
+  uint8_t clues[81],p=0;
+  for (;p<81;p++) clues[p]=(field[p]&0x0200)?((field[p]>>4)&15):0;
+  su_canon(dst,clues);
+}
+
+uint64_t su_canon_hash(const uint8_t *canon) {
+  uint64_t hash=0xcbf29ce484222325ull;
+  uint8_t i=81;
+  for (;i-->0;canon++) hash=(hash^*canon)*0x100000001b3ull;
+  return hash;
+}
+
+/* Hash index.
+ * Open addressing with linear probing, kept under half full. Zero marks an empty slot.
+ */
+
+#if BC_PLATFORM!=BC_PLATFORM_tiny
+
+void su_canon_index_cleanup(struct su_canon_index *index) {
+  if (index->v) free(index->v);
+  memset(index,0,sizeof(struct su_canon_index));
+}
+
+static int su_canon_index_grow(struct su_canon_index *index) {
+  uint32_t na=index->a?(index->a<<1):1024;
+  if (na<index->a) return -1;
+  uint64_t *nv=calloc(na,sizeof(uint64_t));
+  if (!nv) return -1;
+  uint32_t i=0; for (;i<index->a;i++) {
+    if (!index->v[i]) continue;
+    uint32_t p=index->v[i]&(na-1);
+    while (nv[p]) p=(p+1)&(na-1);
+    nv[p]=index->v[i];
+  }
+  if (index->v) free(index->v);
+  index->v=nv;
+  index->a=na;
+  return 0;
+}
+
+int su_canon_index_add(struct su_canon_index *index,uint64_t hash) {
+  if (!hash) hash=1;
+  if ((index->c+1)*2>index->a) {
+    if (su_canon_index_grow(index)<0) return -1;
+  }
+  uint32_t p=hash&(index->a-1);
+  while (index->v[p]) {
+    if (index->v[p]==hash) return 0;
+    p=(p+1)&(index->a-1);
+  }
+  index->v[p]=hash;
+  index->c++;
+  return 1;
+}
+
+#endif
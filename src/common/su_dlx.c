@@ -0,0 +1,209 @@
+#include "platform.h"
+#include "sudoku.h"
+#include <string.h>
+
+#if BC_PLATFORM!=BC_PLATFORM_tiny
+
+/* Matrix layout.
+ * Node 0 is the root, 1..324 are column headers, then 4 nodes for each of 729 rows.
+ * Row (p*9+digit-1) covers one column in each of four groups:
+ *   0..80    cell p is filled
+ *   81..161  row has digit
+ *   162..242 column has digit
+ *   243..323 zone has digit
+ */
+ 
+#define SU_DLX_COLUMNS 324
+#define SU_DLX_ROWS 729
+#define SU_DLX_NODES (1+SU_DLX_COLUMNS+SU_DLX_ROWS*4)
+
+struct su_dlx_node {
+  uint16_t l,r,u,d;
+  uint16_t c; // column header
+  uint16_t row; // 0..728, or 0xffff for root and headers
+};
+
+struct su_dlx {
+  struct su_dlx_node nodev[SU_DLX_NODES];
+  uint16_t sizev[1+SU_DLX_COLUMNS];
+  uint16_t stack[81]; // rows chosen by search
+  uint8_t stackc;
+  uint32_t limit,count;
+  uint8_t *solution;
+  const uint8_t *clues;
+  uint8_t ready;
+};
+
+static __thread struct su_dlx su_dlx={0};
+
+/* Build the full matrix. Only happens once per thread.
+ */
+ 
+static void su_dlx_build(struct su_dlx *dlx) {
+  struct su_dlx_node *nodev=dlx->nodev;
+  uint16_t i=0;
+  for (;i<=SU_DLX_COLUMNS;i++) {
+    nodev[i].l=i?(i-1):SU_DLX_COLUMNS;
+    nodev[i].r=(i<SU_DLX_COLUMNS)?(i+1):0;
+    nodev[i].u=nodev[i].d=nodev[i].c=i;
+    nodev[i].row=0xffff;
+    dlx->sizev[i]=0;
+  }
+  uint16_t nodep=1+SU_DLX_COLUMNS;
+  uint16_t row=0; for (;row<SU_DLX_ROWS;row++,nodep+=4) {
+    uint8_t p=row/9,d=row%9;
+    uint16_t colv[4]={
+      1+p,
+      1+81+su_cell_unitv[p][1]%9*9+d,
+      1+162+su_cell_unitv[p][0]*9+d,
+      1+243+(su_cell_unitv[p][2]-18)*9+d,
+    };
+    for (i=0;i<4;i++) {
+      struct su_dlx_node *node=nodev+nodep+i;
+      uint16_t col=colv[i];
+      node->l=nodep+(i+3)%4;
+      node->r=nodep+(i+1)%4;
+      node->c=col;
+      node->row=row;
+      node->d=col;
+      node->u=nodev[col].u;
+      nodev[nodev[col].u].d=nodep+i;
+      nodev[col].u=nodep+i;
+      dlx->sizev[col]++;
+    }
+  }
+  dlx->ready=1;
+}
+
+/* Cover and uncover.
+ */
+ 
+static void su_dlx_cover(struct su_dlx *dlx,uint16_t col) {
+  struct su_dlx_node *nodev=dlx->nodev;
+  nodev[nodev[col].r].l=nodev[col].l;
+  nodev[nodev[col].l].r=nodev[col].r;
+  uint16_t i=nodev[col].d;
+  for (;i!=col;i=nodev[i].d) {
+    uint16_t j=nodev[i].r;
+    for (;j!=i;j=nodev[j].r) {
+      nodev[nodev[j].d].u=nodev[j].u;
+      nodev[nodev[j].u].d=nodev[j].d;
+      dlx->sizev[nodev[j].c]--;
+    }
+  }
+}
+
+static void su_dlx_uncover(struct su_dlx *dlx,uint16_t col) {
+  struct su_dlx_node *nodev=dlx->nodev;
+  uint16_t i=nodev[col].u;
+  for (;i!=col;i=nodev[i].u) {
+    uint16_t j=nodev[i].l;
+    for (;j!=i;j=nodev[j].l) {
+      dlx->sizev[nodev[j].c]++;
+      nodev[nodev[j].d].u=j;
+      nodev[nodev[j].u].d=j;
+    }
+  }
+  nodev[nodev[col].r].l=col;
+  nodev[nodev[col].l].r=col;
+}
+
+/* Choosing a row means covering every other column it touches.
+ * Clue rows are not in any column list at that point, so cover their own column too.
+ */
+ 
+static void su_dlx_select(struct su_dlx *dlx,uint16_t node) {
+  uint16_t j=dlx->nodev[node].r;
+  for (;j!=node;j=dlx->nodev[j].r) su_dlx_cover(dlx,dlx->nodev[j].c);
+}
+
+static void su_dlx_unselect(struct su_dlx *dlx,uint16_t node) {
+  uint16_t j=dlx->nodev[node].l;
+  for (;j!=node;j=dlx->nodev[j].l) su_dlx_uncover(dlx,dlx->nodev[j].c);
+}
+
+/* Search.
+ */
+ 
+static void su_dlx_search(struct su_dlx *dlx) {
+  struct su_dlx_node *nodev=dlx->nodev;
+  if (!nodev[0].r) {
+    if (!dlx->count++&&dlx->solution) {
+      memcpy(dlx->solution,dlx->clues,81);
+      uint8_t i=0; for (;i<dlx->stackc;i++) {
+        uint16_t row=dlx->stack[i];
+        dlx->solution[row/9]=row%9+1;
+      }
+    }
+    return;
+  }
+  uint16_t col=nodev[0].r,best=col,bestsize=0xffff;
+  for (;col;col=nodev[col].r) {
+    if (dlx->sizev[col]<bestsize) {
+      best=col;
+      if (!(bestsize=dlx->sizev[col])) return;
+      if (bestsize==1) break;
+    }
+  }
+  su_dlx_cover(dlx,best);
+  uint16_t i=nodev[best].d;
+  for (;(i!=best)&&(dlx->count<dlx->limit);i=nodev[i].d) {
+    dlx->stack[dlx->stackc++]=nodev[i].row;
+    su_dlx_select(dlx,i);
+    su_dlx_search(dlx);
+    su_dlx_unselect(dlx,i);
+    dlx->stackc--;
+  }
+  su_dlx_uncover(dlx,best);
+}
+
+/* Count solutions, main entry point.
+ */
+ 
+uint32_t su_dlx_count(uint8_t *solution,const uint8_t *clues,uint32_t limit) {
+  struct su_dlx *dlx=&su_dlx;
+  if (!dlx->ready) su_dlx_build(dlx);
+  
+  /* Validate clues before touching the matrix; a conflicting pair would ask us to cover a column twice.
+   */
+  uint16_t used[27]={0};
+  uint8_t p=0; for (;p<81;p++) {
+    if (!clues[p]) continue;
+    if (clues[p]>9) return 0;
+    uint16_t bit=1<<(clues[p]-1);
+    const uint8_t *u=su_cell_unitv[p];
+    if ((used[u[0]]|used[u[1]]|used[u[2]])&bit) return 0;
+    used[u[0]]|=bit;
+    used[u[1]]|=bit;
+    used[u[2]]|=bit;
+  }
+  
+  /* Each clue's row gets selected in full: its own cell column, then the rest.
+   * Undo in reverse order after the search, leaving the matrix ready for the next call.
+   */
+  uint16_t cluev[81];
+  uint8_t cluec=0;
+  for (p=0;p<81;p++) {
+    if (!clues[p]) continue;
+    uint16_t node=1+SU_DLX_COLUMNS+(p*9+clues[p]-1)*4;
+    su_dlx_cover(dlx,dlx->nodev[node].c);
+    su_dlx_select(dlx,node);
+    cluev[cluec++]=node;
+  }
+  
+  dlx->limit=limit;
+  dlx->count=0;
+  dlx->stackc=0;
+  dlx->solution=solution;
+  dlx->clues=clues;
+  if (limit) su_dlx_search(dlx);
+  
+  while (cluec-->0) {
+    uint16_t node=cluev[cluec];
+    su_dlx_unselect(dlx,node);
+    su_dlx_uncover(dlx,dlx->nodev[node].c);
+  }
+  return dlx->count;
+}
+
+#endif
@@ -0,0 +1,471 @@
+#include <stdint.h>
+#include <string.h>
+#include "sudoku.h"
+
+#if SU_STATS
+  #include <time.h>
+  static uint64_t su_stats_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint64_t)ts.tv_sec*1000000000ull+ts.tv_nsec;
+  }
+#endif
+
+/* PRNG: xoshiro128**, seeded through splitmix64.
+ * Everything is 32-bit shifts and adds, cheap on the Tiny.
+ */
+
+void su_rng_seed(struct su_rng *rng,uint64_t seed) {
+  uint8_t i=0; for (;i<4;i+=2) {
+    uint64_t z=(seed+=0x9e3779b97f4a7c15ull);
+    z=(z^(z>>30))*0xbf58476d1ce4e5b9ull;
+    z=(z^(z>>27))*0x94d049bb133111ebull;
+    z^=z>>31;
+    rng->s[i]=z;
+    rng->s[i+1]=z>>32;
+  }
+  if (!(rng->s[0]|rng->s[1]|rng->s[2]|rng->s[3])) rng->s[0]=1;
+}
+
+static inline uint32_t su_rng_rotl(uint32_t x,uint8_t k) {
+  return (x<<k)|(x>>(32-k));
+}
+
+uint32_t su_rng_next(struct su_rng *rng) {
+  uint32_t *s=rng->s;
+  uint32_t result=su_rng_rotl(s[1]*5,7)*9;
+  uint32_t t=s[1]<<9;
+  s[2]^=s[0];
+  s[3]^=s[1];
+  s[1]^=s[2];
+  s[0]^=s[3];
+  s[2]^=t;
+  s[3]=su_rng_rotl(s[3],11);
+  return result;
+}
+
+/* Lemire's multiply-and-reject, so no value is favored and we only divide on the rare rejection path.
+ */
+ 
+uint32_t su_rng_below(struct su_rng *rng,uint32_t n) {
+  if (n<2) return 0;
+  uint64_t m=(uint64_t)su_rng_next(rng)*n;
+  uint32_t lo=m;
+  if (lo<n) {
+    uint32_t threshold=-n%n;
+    while (lo<threshold) {
+      m=(uint64_t)su_rng_next(rng)*n;
+      lo=m;
+    }
+  }
+  return m>>32;
+}
+
+/* Generator context.
+ */
+
+void su_generator_init(struct su_generator *g,uint64_t seed,su_count_fn count) {
+  memset(g,0,sizeof(struct su_generator));
+  g->count=count?count:su_count;
+  su_rng_seed(&g->rng,seed);
+}
+
+/* Fill values randomly.
+ * Depth-first over the most constrained blank cell, trying its candidates in random order.
+ * A dead end only backs up one cell, and we give up after SU_FILL_BACKTRACK_LIMIT of them, so each attempt is bounded.
+ * In practice an attempt almost never backtracks at all.
+ * Nonzero on success, zero if we ran out of budget.
+ */
+ 
+#define SU_FILL_BACKTRACK_LIMIT 200
+
+struct su_fill_frame {
+  uint8_t p; // Cell we're deciding.
+  uint8_t mark; // Solver trail length before deciding it.
+  uint16_t cand; // Candidates not tried yet.
+};
+ 
+static uint8_t su_generator_fill(struct su_generator *g) {
+  struct su_solver solver;
+  struct su_fill_frame stack[81];
+  uint8_t stackc=0;
+  uint16_t backtrackc=0;
+  su_solver_init(&solver);
+  #if SU_STATS
+    solver.stats=&g->stats;
+  #endif
+  while (solver.trailc<81) {
+  
+    uint8_t best=0,bestc=10,p=0;
+    for (;p<81;p++) {
+      if (solver.value[p]) continue;
+      uint8_t c=su_popcount(su_solver_candidates(&solver,p));
+      if (c<bestc) {
+        best=p;
+        if ((bestc=c)<=1) break;
+      }
+    }
+    struct su_fill_frame *frame=stack+stackc++;
+    frame->p=best;
+    frame->mark=solver.trailc;
+    frame->cand=su_solver_candidates(&solver,best);
+    
+    while (!frame->cand) {
+      SU_STAT(&g->stats,backtracks,1)
+      if (++backtrackc>SU_FILL_BACKTRACK_LIMIT) return 0;
+      if (!--stackc) return 0;
+      frame=stack+stackc-1;
+      su_solver_undo(&solver,frame->mark);
+    }
+    uint16_t cand=frame->cand;
+    uint8_t pick=su_rng_below(&g->rng,su_popcount(cand));
+    while (pick--) cand&=cand-1;
+    cand&=-cand;
+    frame->cand&=~cand;
+    su_solver_place(&solver,frame->p,su_mask_digit(cand));
+  }
+  memcpy(g->value,solver.value,81);
+  return 1;
+}
+
+/* Pick a hidden cell at random.
+ * 0xff if everything is exposed.
+ */
+ 
+static uint8_t su_generator_random_hidden_cell(struct su_generator *g) {
+  uint8_t optc=0,p=0;
+  uint8_t optv[81];
+  for (;p<81;p++) if (!g->expose[p]) optv[optc++]=p;
+  if (!optc) return 0xff;
+  return optv[su_rng_below(&g->rng,optc)];
+}
+
+/* Mark a cell exposed and update possible for all neighbors.
+ */
+ 
+static void su_generator_expose_cell(struct su_generator *g,uint8_t p) {
+  uint16_t bit=1<<(g->value[p]-1);
+  g->expose[p]=1;
+  g->possible[p]=bit;
+  const uint8_t *peer=su_peerv[p];
+  uint8_t i=20;
+  for (;i-->0;peer++) {
+    if (g->expose[*peer]) continue;
+    g->possible[*peer]&=~bit;
+  }
+}
+
+/* Given the "possible" masks of one unit's hidden cells, detect subgroups and apply their restriction.
+ * Returns the count of masks we changed.
+ */
+ 
+static uint8_t su_detect_and_apply_subgroups(uint16_t *mv,uint8_t pc) {
+  uint8_t result=0;
+  uint8_t ai=pc;
+  while (ai-->0) {
+    uint16_t forbitten=~mv[ai];
+    // How many of (a)'s peers contain no more possibilities than (a). Includes (a) itself, so at least 1.
+    uint8_t subc=su_kernel_count_within(mv,pc,mv[ai]);
+    if (subc==su_popcount(mv[ai]&SU_ALL)) {
+      // There is a subgroup among the non-forbittens. Remove (a)'s full mask from all other neighbors.
+      uint8_t bi=pc;
+      while (bi-->0) {
+        if (!(mv[bi]&forbitten)) continue;
+        if (!(mv[bi]&~forbitten)) continue;
+        mv[bi]&=forbitten;
+        result++;
+      }
+    }
+  }
+  return result;
+}
+
+/* Update exposure phase.
+ * Return <0 if the puzzle became unsolvable (shouldn't be possible).
+ * 0 if the puzzle is ready, >0 if we changed something.
+ */
+ 
+static int8_t su_generator_update_exposure(struct su_generator *g) {
+  uint8_t result=0;
+  
+  /* If each cell is either exposed, or has just one "possible" bit, we're solved.
+   * Exposed cells always have exactly their own bit, so we don't need to skip them.
+   * Shouldn't be possible, but if a "possible" reduces to zero, fail.
+   */
+  switch (su_kernel_singles(g->possible,81)) {
+    case -1: return -1; // shouldn't happen
+    case 1: return 0;
+  }
+
+  /* Within each of the 27 axes, identify groups with restricted membership based on (g->possible).
+   * Meaning like, if there's a row with 5 open cells, and two of them have only (1,2) possible, 
+   * we can remove (1,2) from the possibilities of the other cells.
+   * An edge case of this: When a cell has just one possible, we remove that one from its neighbors.
+   */
+  uint8_t i;
+  uint8_t pv[9];
+  uint16_t mv[9];
+  for (i=0;i<27;i++) {
+    const uint8_t *unit=su_unitv[i];
+    uint8_t pc=0,j=0;
+    for (;j<9;j++) {
+      if (g->expose[unit[j]]) continue;
+      mv[pc]=g->possible[unit[j]];
+      pv[pc++]=unit[j];
+    }
+    uint8_t changec=su_detect_and_apply_subgroups(mv,pc);
+    if (changec) {
+      for (j=0;j<pc;j++) g->possible[pv[j]]=mv[j];
+      SU_STAT(&g->stats,eliminations,changec)
+      result=1;
+    }
+  }
+  if (result) return 1;
+
+  /* Nothing changed, so we need to expose one randomly and try again.
+   */
+  su_generator_expose_cell(g,su_generator_random_hidden_cell(g));
+  return 1;
+}
+
+/* Begin exposure phase: Rewrite (g->expose) from scratch and expose a few random cells.
+ * su_generator_update_exposure() then runs until everything is determined.
+ */
+ 
+static void su_generator_expose_begin(struct su_generator *g) {
+  memset(g->expose,0,81);
+  memset(g->possible,0xff,162);
+  
+  /* Start by exposing 15 random cells, a little under the 17 that any unique puzzle needs.
+   * Exposure adds what logic needs, and reduction takes away what uniqueness doesn't.
+   */
+  uint8_t i=15; while (i-->0) {
+    su_generator_expose_cell(g,su_generator_random_hidden_cell(g));
+  }
+}
+
+/* Hide clues that the puzzle doesn't need.
+ * Exposure only proves the puzzle is solvable by subgroup logic, and it tends to leave much more than necessary.
+ * Visit each exposed cell in random order, and keep it hidden if the solution is still unique.
+ * If (symmetric), first expose the partner of every exposed cell, then visit them in pairs.
+ * With the bitboard backend, we keep the clues loaded in (g->solver) and add or remove one at a time,
+ * rather than reloading all of them for every trial.
+ * "begin" returns zero if the exposed set wasn't unique to begin with.
+ * "step" tries one cell or pair.
+ */
+ 
+static uint8_t su_generator_reduce_begin(struct su_generator *g) {
+  uint8_t p=0;
+  g->orderc=g->orderp=0;
+  if (g->symmetric) {
+    for (;p<41;p++) {
+      if (g->expose[p]||g->expose[80-p]) g->expose[p]=g->expose[80-p]=1;
+    }
+  }
+  for (p=0;p<81;p++) {
+    if (g->expose[p]) {
+      g->clues[p]=g->value[p];
+      if (!g->symmetric||(p<=40)) g->order[g->orderc++]=p;
+    } else {
+      g->clues[p]=0;
+    }
+  }
+  if (g->count==su_count) {
+    su_solver_load(&g->solver,g->clues);
+    #if SU_STATS
+      g->solver.stats=&g->stats;
+    #endif
+    if (su_solver_count(&g->solver,2)!=1) return 0;
+  } else {
+    if (g->count(0,g->clues,2)!=1) return 0;
+  }
+  uint8_t i=g->orderc;
+  while (i>1) {
+    uint8_t j=su_rng_below(&g->rng,i);
+    i--;
+    uint8_t tmp=g->order[i];
+    g->order[i]=g->order[j];
+    g->order[j]=tmp;
+  }
+  return 1;
+}
+
+/* Nonzero if blank cell (p) can only be (digit), by naked or hidden single, given what's in (solver).
+ * If the puzzle was unique with (p) filled in, it's still unique without it, and we don't need to search.
+ */
+ 
+static uint8_t su_generator_forced(const struct su_solver *solver,uint8_t p,uint8_t digit) {
+  uint16_t bit=1<<(digit-1);
+  uint16_t cand=su_solver_candidates(solver,p);
+  if (cand==bit) return 1;
+  const uint8_t *u=su_cell_unitv[p];
+  uint8_t i=0; for (;i<3;i++) {
+    const uint8_t *pv=su_unitv[u[i]];
+    uint8_t j=0; for (;j<9;j++) {
+      if (pv[j]==p) continue;
+      if (su_solver_candidates(solver,pv[j])&bit) break;
+    }
+    if (j>=9) return 1;
+  }
+  return 0;
+}
+
+static void su_generator_reduce_step(struct su_generator *g) {
+  uint8_t p=g->order[g->orderp++];
+  uint8_t q=g->symmetric?(80-p):p;
+  g->clues[p]=g->clues[q]=0;
+  uint32_t count;
+  SU_STAT(&g->stats,trials,1)
+  if (g->count==su_count) {
+    su_solver_remove(&g->solver,p);
+    su_solver_remove(&g->solver,q);
+    if (su_generator_forced(&g->solver,p,g->value[p])&&su_generator_forced(&g->solver,q,g->value[q])) {
+      count=1;
+    } else {
+      SU_STAT(&g->stats,searches,1)
+      if ((count=su_solver_count(&g->solver,2))!=1) {
+        su_solver_place(&g->solver,p,g->value[p]);
+        if (q!=p) su_solver_place(&g->solver,q,g->value[q]);
+      }
+    }
+  } else {
+    SU_STAT(&g->stats,searches,1)
+    count=g->count(0,g->clues,2);
+  }
+  if (count==1) {
+    g->expose[p]=g->expose[q]=0;
+  } else {
+    g->clues[p]=g->value[p];
+    g->clues[q]=g->value[q];
+  }
+}
+
+/* Print the output field.
+ */
+ 
+static void su_generator_print(uint16_t *dst,const struct su_generator *g) {
+  uint8_t i=81;
+  const uint8_t *expose=g->expose;
+  const uint8_t *value=g->value;
+  for (;i-->0;dst++,expose++,value++) {
+    if (*expose) {
+      *dst=0x0300|((*value)<<4)|(*value);
+    } else {
+      *dst=(*value)<<4;
+    }
+  }
+}
+
+/* Step through generation.
+ */
+
+void su_generator_begin(struct su_generator *g) {
+  g->fillc=g->repc=g->retryc=0;
+  g->phase=SU_GENERATOR_FILL;
+  #if SU_STATS
+    memset(&g->stats,0,sizeof(struct su_stats));
+  #endif
+}
+
+static uint8_t su_generator_step_inner(struct su_generator *g) {
+  switch (g->phase) {
+  
+    case SU_GENERATOR_FILL: {
+        g->fillc++;
+        if (!su_generator_fill(g)) return 0;
+        su_generator_expose_begin(g);
+        g->phase=SU_GENERATOR_EXPOSE;
+      } return 5;
+      
+    case SU_GENERATOR_EXPOSE: {
+        g->repc++;
+        int8_t err=su_generator_update_exposure(g);
+        if (err<0) {
+          SU_STAT(&g->stats,contradictions,1)
+          g->retryc++;
+          g->phase=SU_GENERATOR_FILL;
+          return 0;
+        }
+        if (err) return (g->repc<40)?(5+g->repc):45; // Usually 30 to 70 passes, no way to tell in advance.
+        if (!su_generator_reduce_begin(g)) { // Exposed puzzle is not unique.
+          g->retryc++;
+          g->phase=SU_GENERATOR_FILL;
+          return 0;
+        }
+        g->phase=SU_GENERATOR_REDUCE;
+      } return 50;
+      
+    case SU_GENERATOR_REDUCE: {
+        if (g->orderp<g->orderc) {
+          su_generator_reduce_step(g);
+          return 50+(g->orderp*45)/g->orderc;
+        }
+        #if SU_STATS
+          uint64_t then=su_stats_now_ns();
+        #endif
+        su_rate(&g->rating,g->clues);
+        #if SU_STATS
+          g->stats.rate_ns+=su_stats_now_ns()-then;
+        #endif
+        g->phase=SU_GENERATOR_DONE;
+      } return 100;
+      
+  }
+  return 100;
+}
+
+uint8_t su_generator_step(struct su_generator *g) {
+  #if SU_STATS
+    uint8_t phase=g->phase;
+    uint64_t then=su_stats_now_ns();
+    uint64_t rate_ns=g->stats.rate_ns;
+    uint8_t progress=su_generator_step_inner(g);
+    uint64_t elapsed=su_stats_now_ns()-then-(g->stats.rate_ns-rate_ns);
+    switch (phase) {
+      case SU_GENERATOR_FILL: g->stats.fill_ns+=elapsed; break;
+      case SU_GENERATOR_EXPOSE: g->stats.expose_ns+=elapsed; break;
+      case SU_GENERATOR_REDUCE: g->stats.reduce_ns+=elapsed; break;
+    }
+    return progress;
+  #else
+    return su_generator_step_inner(g);
+  #endif
+}
+
+void su_generator_stats(struct su_stats *dst,const struct su_generator *g) {
+  #if SU_STATS
+    memcpy(dst,&g->stats,sizeof(struct su_stats));
+    dst->fills=g->fillc;
+    dst->passes=g->repc;
+    dst->restarts=g->retryc;
+  #else
+    memset(dst,0,sizeof(struct su_stats));
+  #endif
+}
+
+uint8_t su_generator_finish(struct su_generator *g,uint16_t *v,struct su_rating *rating) {
+  su_generator_print(v,g);
+  if (rating) memcpy(rating,&g->rating,sizeof(struct su_rating));
+  return g->rating.tier;
+}
+
+/* Generate puzzle, main entry points.
+ */
+
+uint8_t sudoku_generate_seeded(uint16_t *v,uint64_t seed) {
+  struct su_generator g;
+  su_generator_init(&g,seed,0);
+  return su_generator_generate(&g,v,0);
+}
+
+uint8_t su_generator_generate(struct su_generator *g,uint16_t *v,struct su_rating *rating) {
+  su_generator_begin(g);
+  while (su_generator_step(g)<100) ;
+  return su_generator_finish(g,v,rating);
+}
+
+uint8_t su_generator_generate_stats(struct su_generator *g,uint16_t *v,struct su_rating *rating,struct su_stats *stats) {
+  uint8_t tier=su_generator_generate(g,v,rating);
+  if (stats) su_generator_stats(stats,g);
+  return tier;
+}
@@ -0,0 +1,172 @@
+#include "sudoku.h"
+
+/* Mask kernels.
+ * Same results from every implementation, lane for lane. Pick one at compile time:
+ *   SSE2 on x86 (every x86_64 has it), NEON on aarch64, and plain C everywhere else, including the Tiny.
+ * Define SU_KERNEL_PORTABLE to force the plain C, eg to compare against it.
+ */
+
+#if defined(SU_KERNEL_PORTABLE)
+  #define SU_KERNEL_C 1
+#elif defined(__SSE2__)
+  #define SU_KERNEL_SSE2 1
+  #include <emmintrin.h>
+#elif defined(__aarch64__)&&defined(__ARM_NEON)
+  #define SU_KERNEL_NEON 1
+  #include <arm_neon.h>
+#else
+  #define SU_KERNEL_C 1
+#endif
+
+const char *su_kernel_name() {
+  #if SU_KERNEL_SSE2
+    return "sse2";
+  #elif SU_KERNEL_NEON
+    return "neon";
+  #else
+    return "portable";
+  #endif
+}
+
+#if SU_KERNEL_NEON
+// Lane weights, for turning a NEON comparison into a lane mask with one horizontal add.
+static const uint16_t su_kernel_lane_bitv[8]={0x01,0x02,0x04,0x08,0x10,0x20,0x40,0x80};
+#endif
+
+/* Classify masks: All single bits? Scalar tail shared by everyone.
+ */
+
+static int8_t su_kernel_singles_scalar(const uint16_t *v,uint8_t c) {
+  for (;c-->0;v++) {
+    uint16_t m=(*v)&SU_ALL;
+    if (!m) return -1;
+    if (m&(m-1)) return 0;
+  }
+  return 1;
+}
+
+int8_t su_kernel_singles(const uint16_t *v,uint8_t c) {
+  #if SU_KERNEL_SSE2
+    const __m128i all=_mm_set1_epi16(SU_ALL),one=_mm_set1_epi16(1),zero=_mm_setzero_si128();
+    for (;c>=8;c-=8,v+=8) {
+      __m128i m=_mm_and_si128(_mm_loadu_si128((const __m128i*)v),all);
+      __m128i multi=_mm_and_si128(m,_mm_sub_epi16(m,one));
+      // A lane is fine if it's nonzero and (m&(m-1)) is zero. Zero lanes fail (m!=0) instead.
+      __m128i ok=_mm_andnot_si128(_mm_cmpeq_epi16(m,zero),_mm_cmpeq_epi16(multi,zero));
+      int bad=~_mm_movemask_epi8(ok)&0xffff;
+      if (bad) return su_kernel_singles_scalar(v+(__builtin_ctz(bad)>>1),1);
+    }
+  #elif SU_KERNEL_NEON
+    const uint16x8_t all=vdupq_n_u16(SU_ALL),one=vdupq_n_u16(1);
+    for (;c>=8;c-=8,v+=8) {
+      uint16x8_t m=vandq_u16(vld1q_u16(v),all);
+      uint16x8_t multi=vandq_u16(m,vsubq_u16(m,one));
+      uint16x8_t bad=vorrq_u16(vceqzq_u16(m),vtstq_u16(multi,multi));
+      uint64_t bits=vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(bad)),0);
+      if (bits) return su_kernel_singles_scalar(v+(__builtin_ctzll(bits)>>3),1);
+    }
+  #endif
+  return su_kernel_singles_scalar(v,c);
+}
+
+/* Count masks with nothing outside (mask).
+ */
+
+uint8_t su_kernel_count_within(const uint16_t *v,uint8_t c,uint16_t mask) {
+  uint8_t n=0;
+  #if SU_KERNEL_SSE2
+    const __m128i outside=_mm_set1_epi16(~mask),zero=_mm_setzero_si128();
+    for (;c>=8;c-=8,v+=8) {
+      __m128i x=_mm_and_si128(_mm_loadu_si128((const __m128i*)v),outside);
+      n+=__builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi16(x,zero)))>>1;
+    }
+  #elif SU_KERNEL_NEON
+    const uint16x8_t outside=vdupq_n_u16(~mask);
+    for (;c>=8;c-=8,v+=8) {
+      uint16x8_t within=vceqzq_u16(vandq_u16(vld1q_u16(v),outside));
+      n+=vaddvq_u16(vshrq_n_u16(within,15));
+    }
+  #endif
+  for (;c-->0;v++) if (!((*v)&~mask)) n++;
+  return n;
+}
+
+/* Transpose 9 cells to 9 digits.
+ */
+
+void su_kernel_positions(uint16_t *posv,const uint16_t *v) {
+  #if SU_KERNEL_SSE2
+    // Shift digit (d) into each lane's sign bit; signed saturation keeps the sign through the pack to bytes.
+    __m128i m=_mm_loadu_si128((const __m128i*)v);
+    #define DIGIT(d) { \
+      __m128i x=_mm_slli_epi16(m,15-(d)); \
+      posv[d]=(_mm_movemask_epi8(_mm_packs_epi16(x,x))&0xff)|((v[8]&(1<<(d)))<<(8-(d))); \
+    }
+    DIGIT(0) DIGIT(1) DIGIT(2) DIGIT(3) DIGIT(4) DIGIT(5) DIGIT(6) DIGIT(7) DIGIT(8)
+    #undef DIGIT
+  #elif SU_KERNEL_NEON
+    uint16x8_t m=vld1q_u16(v),lanebits=vld1q_u16(su_kernel_lane_bitv);
+    uint8_t d=0; for (;d<9;d++) {
+      uint16x8_t hit=vandq_u16(vtstq_u16(m,vdupq_n_u16(1<<d)),lanebits);
+      posv[d]=vaddvq_u16(hit)|(((v[8]>>d)&1)<<8);
+    }
+  #else
+    uint8_t d=0; for (;d<9;d++) posv[d]=0;
+    uint8_t i=0; for (;i<9;i++) {
+      uint16_t cand=v[i]&SU_ALL;
+      for (d=0;cand;cand>>=1,d++) if (cand&1) posv[d]|=1<<i;
+    }
+  #endif
+}
+
+/* Digits appearing once or more, and twice or more.
+ */
+
+uint16_t su_kernel_once_twice(uint16_t *twice,const uint16_t *v,uint8_t c) {
+  uint16_t once=0;
+  *twice=0;
+  #if SU_KERNEL_SSE2
+    if (c>=8) {
+      // Each lane counts its own column, then fold the lanes in half three times.
+      __m128i o=_mm_setzero_si128(),t=_mm_setzero_si128();
+      for (;c>=8;c-=8,v+=8) {
+        __m128i x=_mm_loadu_si128((const __m128i*)v);
+        t=_mm_or_si128(t,_mm_and_si128(o,x));
+        o=_mm_or_si128(o,x);
+      }
+      #define FOLD(bytes) { \
+        __m128i ho=_mm_srli_si128(o,bytes),ht=_mm_srli_si128(t,bytes); \
+        t=_mm_or_si128(_mm_or_si128(t,ht),_mm_and_si128(o,ho)); \
+        o=_mm_or_si128(o,ho); \
+      }
+      FOLD(8) FOLD(4) FOLD(2)
+      #undef FOLD
+      once=_mm_cvtsi128_si32(o);
+      *twice=_mm_cvtsi128_si32(t);
+    }
+  #elif SU_KERNEL_NEON
+    if (c>=8) {
+      uint16x8_t o=vdupq_n_u16(0),t=vdupq_n_u16(0);
+      for (;c>=8;c-=8,v+=8) {
+        uint16x8_t x=vld1q_u16(v);
+        t=vorrq_u16(t,vandq_u16(o,x));
+        o=vorrq_u16(o,x);
+      }
+      uint16x4_t lo=vget_low_u16(o),hi=vget_high_u16(o);
+      uint16x4_t t4=vorr_u16(vorr_u16(vget_low_u16(t),vget_high_u16(t)),vand_u16(lo,hi));
+      uint16x4_t o4=vorr_u16(lo,hi);
+      uint16_t ov[4],tv[4];
+      vst1_u16(ov,o4);
+      vst1_u16(tv,t4);
+      uint8_t i=0; for (;i<4;i++) {
+        *twice|=tv[i]|(once&ov[i]);
+        once|=ov[i];
+      }
+    }
+  #endif
+  for (;c-->0;v++) {
+    *twice|=once&*v;
+    once|=*v;
+  }
+  return once;
+}
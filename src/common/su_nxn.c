@@ -0,0 +1,7 @@
+/* su_nxn.c
+ * The one place sudoku_nxn.h gets its function bodies.
+ */
+
+#include <string.h>
+#define SU_NXN_IMPLEMENT 1
+#include "sudoku_nxn.h"
@@ -0,0 +1,391 @@
+/* su_nxn.h
+ * Bitboard solver and generator for any box size, stamped out once per size by including this file with parameters defined:
+ *   SU_NXN_NAME  Prefix for everything declared, eg su16.
+ *   SU_NXN_BOXW  Box width in cells.
+ *   SU_NXN_BOXH  Box height in cells.
+ *   SU_NXN_MASK  Unsigned type with at least BOXW*BOXH bits, for candidate masks. No wider than 32 bits.
+ *   SU_NXN_CELL  Unsigned type that can count to the cell count inclusive, for cell indices.
+ * Define SU_NXN_IMPLEMENT as well, in exactly one C file, to get the functions. See sudoku_nxn.h and su_nxn.c.
+ * No include guard, on purpose. Everything is undefined at the end, ready for the next size.
+ *
+ * Geometry is all compile-time constants, so the divisions fold away and each size gets code as tight as if written by hand.
+ * Grids are N*N bytes, row-major, 0 for blank or 1..N, same as the classic 9x9 in sudoku.h.
+ * Units are numbered the same way too: columns 0..N-1, rows N..2N-1, boxes 2N..3N-1.
+ */
+
+#define SU_NXN_CAT2(a,b) a##b
+#define SU_NXN_CAT(a,b) SU_NXN_CAT2(a,b)
+#define SU_NXN_ID(suffix) SU_NXN_CAT(SU_NXN_NAME,suffix)
+
+#define SU_NXN_N (SU_NXN_BOXW*SU_NXN_BOXH)
+#define SU_NXN_C (SU_NXN_N*SU_NXN_N)
+#define SU_NXN_ALL ((SU_NXN_MASK)(((uint64_t)1<<SU_NXN_N)-1))
+
+/* Declarations.
+ ***********************************************************************/
+
+struct SU_NXN_ID(_solver) {
+  uint8_t value[SU_NXN_C];
+  SU_NXN_MASK used[SU_NXN_N*3]; // Digits placed in each unit.
+  SU_NXN_CELL trail[SU_NXN_C]; // Cells placed since init, in order.
+  SU_NXN_CELL trailc;
+  uint8_t conflict; // Set by load if clues conflicted.
+  uint32_t limit; // Stop searching at so many solutions.
+  uint32_t count; // Solutions found so far.
+  uint8_t solution[SU_NXN_C]; // First solution found.
+};
+
+struct SU_NXN_ID(_generator) {
+  struct su_rng rng;
+  uint8_t symmetric; // Set after init: Nonzero to keep clues rotationally symmetric about the center.
+  uint16_t fillc; // Attempts to fill the solution grid, last time.
+  uint8_t value[SU_NXN_C]; // Solution.
+  uint8_t clues[SU_NXN_C];
+  SU_NXN_CELL order[SU_NXN_C];
+  struct SU_NXN_ID(_solver) solver;
+};
+
+// Same contracts as the classic su_solver_* and su_count.
+void SU_NXN_ID(_solver_init)(struct SU_NXN_ID(_solver) *solver);
+int8_t SU_NXN_ID(_solver_load)(struct SU_NXN_ID(_solver) *solver,const uint8_t *src);
+int8_t SU_NXN_ID(_solver_place)(struct SU_NXN_ID(_solver) *solver,SU_NXN_CELL p,uint8_t digit);
+void SU_NXN_ID(_solver_undo)(struct SU_NXN_ID(_solver) *solver,SU_NXN_CELL mark);
+void SU_NXN_ID(_solver_remove)(struct SU_NXN_ID(_solver) *solver,SU_NXN_CELL p);
+int16_t SU_NXN_ID(_solver_propagate)(struct SU_NXN_ID(_solver) *solver);
+uint32_t SU_NXN_ID(_solver_count)(struct SU_NXN_ID(_solver) *solver,uint32_t limit);
+uint32_t SU_NXN_ID(_count)(uint8_t *solution,const uint8_t *clues,uint32_t limit);
+
+/* Generate a minimal puzzle: Fill a random grid, then hide each clue in random order if the solution stays unique.
+ * (clues) and (solution) are optional. Returns the count of clues.
+ */
+void SU_NXN_ID(_generator_init)(struct SU_NXN_ID(_generator) *g,uint64_t seed);
+SU_NXN_CELL SU_NXN_ID(_generator_generate)(struct SU_NXN_ID(_generator) *g,uint8_t *clues,uint8_t *solution);
+
+/* Implementation.
+ ***********************************************************************/
+
+#ifdef SU_NXN_IMPLEMENT
+
+/* Geometry.
+ */
+
+static inline uint8_t SU_NXN_ID(_box_of)(SU_NXN_CELL p) {
+  return ((p/SU_NXN_N)/SU_NXN_BOXH)*(SU_NXN_N/SU_NXN_BOXW)+(p%SU_NXN_N)/SU_NXN_BOXW;
+}
+
+// Cell (i) of unit (u).
+static inline SU_NXN_CELL SU_NXN_ID(_unit_cell)(uint8_t u,uint8_t i) {
+  if (u<SU_NXN_N) return i*SU_NXN_N+u;
+  if (u<SU_NXN_N*2) return (u-SU_NXN_N)*SU_NXN_N+i;
+  uint8_t b=u-SU_NXN_N*2;
+  uint8_t row=(b/(SU_NXN_N/SU_NXN_BOXW))*SU_NXN_BOXH+i/SU_NXN_BOXW;
+  uint8_t col=(b%(SU_NXN_N/SU_NXN_BOXW))*SU_NXN_BOXW+i%SU_NXN_BOXW;
+  return row*SU_NXN_N+col;
+}
+
+static inline SU_NXN_MASK SU_NXN_ID(_candidates)(const struct SU_NXN_ID(_solver) *solver,SU_NXN_CELL p) {
+  if (solver->value[p]) return 0;
+  return ~(
+    solver->used[p%SU_NXN_N]|
+    solver->used[SU_NXN_N+p/SU_NXN_N]|
+    solver->used[SU_NXN_N*2+SU_NXN_ID(_box_of)(p)]
+  )&SU_NXN_ALL;
+}
+
+static inline uint8_t SU_NXN_ID(_mask_digit)(SU_NXN_MASK mask) {
+  return mask?(__builtin_ctz(mask)+1):0;
+}
+
+/* Solver basics.
+ */
+
+void SU_NXN_ID(_solver_init)(struct SU_NXN_ID(_solver) *solver) {
+  memset(solver->value,0,sizeof(solver->value));
+  memset(solver->used,0,sizeof(solver->used));
+  solver->trailc=0;
+  solver->conflict=0;
+  solver->limit=0;
+  solver->count=0;
+}
+
+int8_t SU_NXN_ID(_solver_load)(struct SU_NXN_ID(_solver) *solver,const uint8_t *src) {
+  SU_NXN_ID(_solver_init)(solver);
+  int8_t result=0;
+  SU_NXN_CELL p=0; for (;p<SU_NXN_C;p++) {
+    if (!src[p]) continue;
+    if (SU_NXN_ID(_solver_place)(solver,p,src[p])<0) result=-1;
+  }
+  solver->conflict=(result<0);
+  return result;
+}
+
+int8_t SU_NXN_ID(_solver_place)(struct SU_NXN_ID(_solver) *solver,SU_NXN_CELL p,uint8_t digit) {
+  if ((digit<1)||(digit>SU_NXN_N)||solver->value[p]) return -1;
+  SU_NXN_MASK bit=(SU_NXN_MASK)1<<(digit-1);
+  uint8_t col=p%SU_NXN_N,row=SU_NXN_N+p/SU_NXN_N,box=SU_NXN_N*2+SU_NXN_ID(_box_of)(p);
+  if ((solver->used[col]|solver->used[row]|solver->used[box])&bit) return -1;
+  solver->used[col]|=bit;
+  solver->used[row]|=bit;
+  solver->used[box]|=bit;
+  solver->value[p]=digit;
+  solver->trail[solver->trailc++]=p;
+  return 0;
+}
+
+static void SU_NXN_ID(_solver_unplace)(struct SU_NXN_ID(_solver) *solver,SU_NXN_CELL p) {
+  SU_NXN_MASK mask=~((SU_NXN_MASK)1<<(solver->value[p]-1));
+  solver->used[p%SU_NXN_N]&=mask;
+  solver->used[SU_NXN_N+p/SU_NXN_N]&=mask;
+  solver->used[SU_NXN_N*2+SU_NXN_ID(_box_of)(p)]&=mask;
+  solver->value[p]=0;
+}
+
+void SU_NXN_ID(_solver_undo)(struct SU_NXN_ID(_solver) *solver,SU_NXN_CELL mark) {
+  while (solver->trailc>mark) {
+    SU_NXN_ID(_solver_unplace)(solver,solver->trail[--(solver->trailc)]);
+  }
+}
+
+void SU_NXN_ID(_solver_remove)(struct SU_NXN_ID(_solver) *solver,SU_NXN_CELL p) {
+  if (!solver->value[p]) return;
+  SU_NXN_ID(_solver_unplace)(solver,p);
+  SU_NXN_CELL i=0; for (;i<solver->trailc;i++) {
+    if (solver->trail[i]!=p) continue;
+    solver->trailc--;
+    memmove(solver->trail+i,solver->trail+i+1,sizeof(SU_NXN_CELL)*(solver->trailc-i));
+    break;
+  }
+}
+
+/* Propagate singles.
+ */
+
+static int16_t SU_NXN_ID(_solver_naked_singles)(struct SU_NXN_ID(_solver) *solver) {
+  int16_t placec=0;
+  SU_NXN_CELL p=0; for (;p<SU_NXN_C;p++) {
+    if (solver->value[p]) continue;
+    SU_NXN_MASK cand=SU_NXN_ID(_candidates)(solver,p);
+    if (!cand) return -1;
+    if (cand&(cand-1)) continue;
+    SU_NXN_ID(_solver_place)(solver,p,SU_NXN_ID(_mask_digit)(cand));
+    placec++;
+  }
+  return placec;
+}
+
+static int16_t SU_NXN_ID(_solver_hidden_singles)(struct SU_NXN_ID(_solver) *solver) {
+  int16_t placec=0;
+  uint8_t u=0; for (;u<SU_NXN_N*3;u++) {
+    SU_NXN_MASK need=~solver->used[u]&SU_NXN_ALL;
+    if (!need) continue;
+    SU_NXN_MASK once=0,twice=0;
+    uint8_t i=0; for (;i<SU_NXN_N;i++) {
+      SU_NXN_MASK cand=SU_NXN_ID(_candidates)(solver,SU_NXN_ID(_unit_cell)(u,i));
+      twice|=once&cand;
+      once|=cand;
+    }
+    if (need&~once) return -1; // Some digit has nowhere to go.
+    SU_NXN_MASK single=once&~twice;
+    while (single) {
+      SU_NXN_MASK bit=single&-single;
+      single&=~bit;
+      for (i=0;i<SU_NXN_N;i++) {
+        SU_NXN_CELL p=SU_NXN_ID(_unit_cell)(u,i);
+        if (!(SU_NXN_ID(_candidates)(solver,p)&bit)) continue;
+        if (SU_NXN_ID(_solver_place)(solver,p,SU_NXN_ID(_mask_digit)(bit))<0) return -1;
+        placec++;
+        break;
+      }
+      if (i>=SU_NXN_N) return -1; // Lost its only home to an earlier placement in this pass.
+    }
+  }
+  return placec;
+}
+
+int16_t SU_NXN_ID(_solver_propagate)(struct SU_NXN_ID(_solver) *solver) {
+  int16_t total=0;
+  while (1) {
+    int16_t c=SU_NXN_ID(_solver_naked_singles)(solver);
+    if (c<0) return -1;
+    if (!c) {
+      if ((c=SU_NXN_ID(_solver_hidden_singles)(solver))<0) return -1;
+      if (!c) return total;
+    }
+    total+=c;
+  }
+}
+
+/* Count solutions.
+ */
+
+static void SU_NXN_ID(_solver_search)(struct SU_NXN_ID(_solver) *solver) {
+  SU_NXN_CELL mark=solver->trailc;
+  if (SU_NXN_ID(_solver_propagate)(solver)<0) {
+    SU_NXN_ID(_solver_undo)(solver,mark);
+    return;
+  }
+  SU_NXN_CELL bestp=0,p=0;
+  uint8_t bestc=0xff;
+  for (;p<SU_NXN_C;p++) {
+    if (solver->value[p]) continue;
+    uint8_t c=__builtin_popcount(SU_NXN_ID(_candidates)(solver,p));
+    if (c<bestc) {
+      bestp=p;
+      bestc=c;
+      if (c<=2) break;
+    }
+  }
+  if (bestc==0xff) {
+    if (!solver->count++) memcpy(solver->solution,solver->value,SU_NXN_C);
+    SU_NXN_ID(_solver_undo)(solver,mark);
+    return;
+  }
+  SU_NXN_MASK cand=SU_NXN_ID(_candidates)(solver,bestp);
+  SU_NXN_CELL inner=solver->trailc;
+  while (cand&&(solver->count<solver->limit)) {
+    SU_NXN_MASK bit=cand&-cand;
+    cand&=~bit;
+    SU_NXN_ID(_solver_place)(solver,bestp,SU_NXN_ID(_mask_digit)(bit));
+    SU_NXN_ID(_solver_search)(solver);
+    SU_NXN_ID(_solver_undo)(solver,inner);
+  }
+  SU_NXN_ID(_solver_undo)(solver,mark);
+}
+
+uint32_t SU_NXN_ID(_solver_count)(struct SU_NXN_ID(_solver) *solver,uint32_t limit) {
+  solver->limit=limit;
+  solver->count=0;
+  if (limit&&!solver->conflict) SU_NXN_ID(_solver_search)(solver);
+  return solver->count;
+}
+
+uint32_t SU_NXN_ID(_count)(uint8_t *solution,const uint8_t *clues,uint32_t limit) {
+  struct SU_NXN_ID(_solver) solver;
+  if (SU_NXN_ID(_solver_load)(&solver,clues)<0) return 0;
+  uint32_t count=SU_NXN_ID(_solver_count)(&solver,limit);
+  if (count&&solution) memcpy(solution,solver.solution,SU_NXN_C);
+  return count;
+}
+
+/* Fill a random solution grid, as su_generator does: Depth-first over the most constrained cell, candidates in random order.
+ * Each attempt gets a bounded number of backtracks. Nonzero on success.
+ */
+
+void SU_NXN_ID(_generator_init)(struct SU_NXN_ID(_generator) *g,uint64_t seed) {
+  memset(g,0,sizeof(*g));
+  su_rng_seed(&g->rng,seed);
+}
+
+static uint8_t SU_NXN_ID(_generator_fill)(struct SU_NXN_ID(_generator) *g) {
+  struct SU_NXN_ID(_solver) *solver=&g->solver;
+  struct {
+    SU_NXN_CELL p,mark;
+    SU_NXN_MASK cand;
+  } stack[SU_NXN_C];
+  SU_NXN_CELL stackc=0;
+  uint32_t backtrackc=0;
+  SU_NXN_ID(_solver_init)(solver);
+  while (solver->trailc<SU_NXN_C) {
+    SU_NXN_CELL best=0,p=0;
+    uint8_t bestc=0xff;
+    for (;p<SU_NXN_C;p++) {
+      if (solver->value[p]) continue;
+      uint8_t c=__builtin_popcount(SU_NXN_ID(_candidates)(solver,p));
+      if (c<bestc) {
+        best=p;
+        if ((bestc=c)<=1) break;
+      }
+    }
+    stack[stackc].p=best;
+    stack[stackc].mark=solver->trailc;
+    stack[stackc].cand=SU_NXN_ID(_candidates)(solver,best);
+    stackc++;
+    while (!stack[stackc-1].cand) {
+      if (++backtrackc>SU_NXN_C*4) return 0;
+      if (!--stackc) return 0;
+      SU_NXN_ID(_solver_undo)(solver,stack[stackc-1].mark);
+    }
+    SU_NXN_MASK cand=stack[stackc-1].cand;
+    uint32_t pick=su_rng_below(&g->rng,__builtin_popcount(cand));
+    while (pick--) cand&=cand-1;
+    cand&=-cand;
+    stack[stackc-1].cand&=~cand;
+    SU_NXN_ID(_solver_place)(solver,stack[stackc-1].p,SU_NXN_ID(_mask_digit)(cand));
+  }
+  memcpy(g->value,solver->value,SU_NXN_C);
+  return 1;
+}
+
+/* Nonzero if blank cell (p) can only be (digit), by naked or hidden single.
+ * Then hiding it can't have made the puzzle ambiguous, and we skip the search.
+ */
+
+static uint8_t SU_NXN_ID(_generator_forced)(const struct SU_NXN_ID(_solver) *solver,SU_NXN_CELL p,uint8_t digit) {
+  SU_NXN_MASK bit=(SU_NXN_MASK)1<<(digit-1);
+  if (SU_NXN_ID(_candidates)(solver,p)==bit) return 1;
+  uint8_t unitv[3]={p%SU_NXN_N,SU_NXN_N+p/SU_NXN_N,SU_NXN_N*2+SU_NXN_ID(_box_of)(p)};
+  uint8_t ui=0; for (;ui<3;ui++) {
+    uint8_t i=0; for (;i<SU_NXN_N;i++) {
+      SU_NXN_CELL q=SU_NXN_ID(_unit_cell)(unitv[ui],i);
+      if ((q!=p)&&(SU_NXN_ID(_candidates)(solver,q)&bit)) break;
+    }
+    if (i>=SU_NXN_N) return 1;
+  }
+  return 0;
+}
+
+SU_NXN_CELL SU_NXN_ID(_generator_generate)(struct SU_NXN_ID(_generator) *g,uint8_t *clues,uint8_t *solution) {
+  struct SU_NXN_ID(_solver) *solver=&g->solver;
+  g->fillc=0;
+  do { g->fillc++; } while (!SU_NXN_ID(_generator_fill)(g));
+
+  // Start with every clue, and try to hide each cell (or pair) in random order.
+  memcpy(g->clues,g->value,SU_NXN_C);
+  SU_NXN_CELL orderc=0,p=0;
+  for (;p<SU_NXN_C;p++) {
+    if (!g->symmetric||(p<=SU_NXN_C-1-p)) g->order[orderc++]=p;
+  }
+  SU_NXN_CELL i=orderc;
+  while (i>1) {
+    SU_NXN_CELL j=su_rng_below(&g->rng,i);
+    i--;
+    SU_NXN_CELL tmp=g->order[i];
+    g->order[i]=g->order[j];
+    g->order[j]=tmp;
+  }
+  SU_NXN_CELL cluec=SU_NXN_C;
+  for (i=0;i<orderc;i++) {
+    p=g->order[i];
+    SU_NXN_CELL q=g->symmetric?(SU_NXN_C-1-p):p;
+    SU_NXN_ID(_solver_remove)(solver,p);
+    SU_NXN_ID(_solver_remove)(solver,q);
+    if (
+      (SU_NXN_ID(_generator_forced)(solver,p,g->value[p])&&SU_NXN_ID(_generator_forced)(solver,q,g->value[q]))||
+      (SU_NXN_ID(_solver_count)(solver,2)==1)
+    ) {
+      g->clues[p]=g->clues[q]=0;
+      cluec-=(p==q)?1:2;
+    } else {
+      SU_NXN_ID(_solver_place)(solver,p,g->value[p]);
+      if (q!=p) SU_NXN_ID(_solver_place)(solver,q,g->value[q]);
+    }
+  }
+
+  if (clues) memcpy(clues,g->clues,SU_NXN_C);
+  if (solution) memcpy(solution,g->value,SU_NXN_C);
+  return cluec;
+}
+
+#endif
+
+#undef SU_NXN_ALL
+#undef SU_NXN_C
+#undef SU_NXN_N
+#undef SU_NXN_ID
+#undef SU_NXN_CAT
+#undef SU_NXN_CAT2
+#undef SU_NXN_NAME
+#undef SU_NXN_BOXW
+#undef SU_NXN_BOXH
+#undef SU_NXN_MASK
+#undef SU_NXN_CELL
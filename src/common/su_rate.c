@@ -0,0 +1,559 @@
+#include "sudoku.h"
+#include <string.h>
+
+/* Logical solver state.
+ */
+
+static void su_logic_place(struct su_logic *logic,uint8_t p,uint8_t digit) {
+  uint16_t mask=~(1<<(digit-1));
+  logic->value[p]=digit;
+  logic->cand[p]=0;
+  logic->blankc--;
+  const uint8_t *peer=su_peerv[p];
+  uint8_t i=20;
+  for (;i-->0;peer++) logic->cand[*peer]&=mask;
+}
+
+static int8_t su_logic_load(struct su_logic *logic,const uint8_t *clues) {
+  uint8_t p=0;
+  for (;p<81;p++) {
+    logic->cand[p]=SU_ALL;
+    logic->value[p]=0;
+  }
+  logic->blankc=81;
+  for (p=0;p<81;p++) {
+    if (!clues[p]) continue;
+    if ((clues[p]>9)||!(logic->cand[p]&(1<<(clues[p]-1)))) return -1;
+    su_logic_place(logic,p,clues[p]);
+  }
+  return 0;
+}
+
+static uint8_t su_sees(uint8_t a,uint8_t b) {
+  if (a==b) return 0;
+  const uint8_t *ua=su_cell_unitv[a],*ub=su_cell_unitv[b];
+  return (ua[0]==ub[0])||(ua[1]==ub[1])||(ua[2]==ub[2]);
+}
+
+static uint8_t su_in_unit(uint8_t p,uint8_t u) {
+  const uint8_t *cu=su_cell_unitv[p];
+  return (cu[0]==u)||(cu[1]==u)||(cu[2]==u);
+}
+
+/* For each digit, which of the unit's nine cells could hold it.
+ * Returns the digits already placed in the unit.
+ */
+
+static uint16_t su_logic_positions(uint16_t *posv,const struct su_logic *logic,uint8_t u) {
+  uint16_t placed=0,candv[9];
+  const uint8_t *pv=su_unitv[u];
+  uint8_t i=0; for (;i<9;i++) {
+    uint8_t p=pv[i];
+    candv[i]=logic->cand[p]; // zero if filled
+    if (logic->value[p]) placed|=1<<(logic->value[p]-1);
+  }
+  su_kernel_positions(posv,candv);
+  return placed;
+}
+
+/* Remove (mask) from each cell of unit (u), except cells also in unit (keep), or in (keepcells), a mask of unit indices.
+ * Returns count of cells changed.
+ */
+
+static uint8_t su_logic_eliminate(struct su_logic *logic,uint8_t u,uint16_t mask,uint8_t keep,uint16_t keepcells) {
+  uint8_t c=0;
+  const uint8_t *pv=su_unitv[u];
+  uint8_t i=0; for (;i<9;i++) {
+    uint8_t p=pv[i];
+    if (!(logic->cand[p]&mask)) continue;
+    if (keepcells&(1<<i)) continue;
+    if ((keep<27)&&su_in_unit(p,keep)) continue;
+    logic->cand[p]&=~mask;
+    c++;
+  }
+  return c;
+}
+
+/* Singles.
+ */
+
+static int8_t su_tech_hidden_single(struct su_logic *logic) {
+  int8_t c=0;
+  uint16_t posv[9];
+  uint8_t u=0; for (;u<27;u++) {
+    uint16_t placed=su_logic_positions(posv,logic,u);
+    uint8_t d=0; for (;d<9;d++) {
+      if (placed&(1<<d)) continue;
+      uint16_t pos=posv[d];
+      if (!pos) return -1;
+      if (pos&(pos-1)) continue;
+      uint8_t p=su_unitv[u][su_mask_digit(pos)-1];
+      if (!(logic->cand[p]&(1<<d))) return -1;
+      su_logic_place(logic,p,d+1);
+      c++;
+      placed=su_logic_positions(posv,logic,u);
+    }
+  }
+  return c;
+}
+
+static int8_t su_tech_naked_single(struct su_logic *logic) {
+  int8_t c=0;
+  uint8_t p=0; for (;p<81;p++) {
+    if (logic->value[p]) continue;
+    uint16_t cand=logic->cand[p];
+    if (!cand) return -1;
+    if (cand&(cand-1)) continue;
+    su_logic_place(logic,p,su_mask_digit(cand));
+    c++;
+  }
+  return c;
+}
+
+/* Locked candidates.
+ * Pointing: A digit confined to one line within a zone is cleared from the rest of that line.
+ * Claiming: A digit confined to one zone within a line is cleared from the rest of that zone.
+ * Both come down to the same thing: Unit positions 0-2, 3-5, 6-8 of any line share a zone,
+ * and positions 0-2, 3-5, 6-8 of a zone share a row, and 0,3,6 / 1,4,7 / 2,5,8 share a column.
+ */
+
+static int8_t su_tech_locked(struct su_logic *logic) {
+  uint16_t posv[9];
+  uint8_t u=0; for (;u<27;u++) {
+    uint16_t placed=su_logic_positions(posv,logic,u);
+    uint8_t d=0; for (;d<9;d++) {
+      if (placed&(1<<d)) continue;
+      uint16_t pos=posv[d];
+      if (!(pos&(pos-1))) continue;
+      uint8_t i=0; for (;i<3;i++) {
+        uint8_t other=0xff;
+        if (!(pos&~(0x007<<(i*3)))) {
+          // Confined to one triple. For a line, that's a zone; for a zone, it's a row.
+          if (u<18) other=su_cell_unitv[su_unitv[u][i*3]][2];
+          else other=su_cell_unitv[su_unitv[u][i*3]][1];
+        } else if ((u>=18)&&!(pos&~(0x049<<i))) {
+          other=su_cell_unitv[su_unitv[u][i]][0];
+        }
+        if (other==0xff) continue;
+        if (su_logic_eliminate(logic,other,1<<d,u,0)) return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+/* Naked subsets: (n) cells in a unit whose candidates total (n) digits.
+ * Those digits can be removed from the unit's other cells.
+ */
+
+static int8_t su_tech_naked_subset(struct su_logic *logic,uint8_t n) {
+  uint8_t u=0; for (;u<27;u++) {
+    const uint8_t *pv=su_unitv[u];
+    uint8_t ov[9],oc=0,i,j,k;
+    for (i=0;i<9;i++) {
+      uint16_t cand=logic->cand[pv[i]];
+      if (!cand) continue;
+      if (su_popcount(cand)>n) continue;
+      ov[oc++]=i;
+    }
+    if (oc<n) continue;
+    for (i=0;i<oc;i++) {
+      for (j=i+1;j<oc;j++) {
+        uint16_t ij=logic->cand[pv[ov[i]]]|logic->cand[pv[ov[j]]];
+        uint16_t cells=(1<<ov[i])|(1<<ov[j]);
+        if (n==2) {
+          if (su_popcount(ij)!=2) continue;
+          if (su_logic_eliminate(logic,u,ij,0xff,cells)) return 1;
+          continue;
+        }
+        if (su_popcount(ij)>n) continue;
+        for (k=j+1;k<oc;k++) {
+          uint16_t ijk=ij|logic->cand[pv[ov[k]]];
+          if (su_popcount(ijk)!=n) continue;
+          if (su_logic_eliminate(logic,u,ijk,0xff,cells|(1<<ov[k]))) return 1;
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+static int8_t su_tech_naked_pair(struct su_logic *logic) { return su_tech_naked_subset(logic,2); }
+static int8_t su_tech_naked_triple(struct su_logic *logic) { return su_tech_naked_subset(logic,3); }
+
+/* Hidden subsets: (n) digits in a unit whose positions total (n) cells.
+ * Those cells can't hold anything else.
+ */
+
+static uint8_t su_logic_restrict(struct su_logic *logic,uint8_t u,uint16_t cells,uint16_t digits) {
+  uint8_t c=0,i=0;
+  for (;i<9;i++) {
+    if (!(cells&(1<<i))) continue;
+    uint8_t p=su_unitv[u][i];
+    if (!(logic->cand[p]&~digits)) continue;
+    logic->cand[p]&=digits;
+    c++;
+  }
+  return c;
+}
+
+static int8_t su_tech_hidden_subset(struct su_logic *logic,uint8_t n) {
+  uint16_t posv[9];
+  uint8_t u=0; for (;u<27;u++) {
+    uint16_t placed=su_logic_positions(posv,logic,u);
+    uint8_t dv[9],dc=0,i,j,k;
+    for (i=0;i<9;i++) {
+      if (placed&(1<<i)) continue;
+      uint8_t c=su_popcount(posv[i]);
+      if ((c<2)||(c>n)) continue;
+      dv[dc++]=i;
+    }
+    if (dc<n) continue;
+    for (i=0;i<dc;i++) {
+      for (j=i+1;j<dc;j++) {
+        uint16_t ij=posv[dv[i]]|posv[dv[j]];
+        uint16_t digits=(1<<dv[i])|(1<<dv[j]);
+        if (n==2) {
+          if (su_popcount(ij)!=2) continue;
+          if (su_logic_restrict(logic,u,ij,digits)) return 1;
+          continue;
+        }
+        if (su_popcount(ij)>n) continue;
+        for (k=j+1;k<dc;k++) {
+          uint16_t ijk=ij|posv[dv[k]];
+          if (su_popcount(ijk)!=n) continue;
+          if (su_logic_restrict(logic,u,ijk,digits|(1<<dv[k]))) return 1;
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+static int8_t su_tech_hidden_pair(struct su_logic *logic) { return su_tech_hidden_subset(logic,2); }
+static int8_t su_tech_hidden_triple(struct su_logic *logic) { return su_tech_hidden_subset(logic,3); }
+
+/* Fish: (n) rows where a digit only appears in the same (n) columns, or vice versa.
+ * It can then be removed from those columns in all other rows.
+ * (base) 0 means rows are the base lines and columns the cover; 1 is the reverse.
+ * Within a column, the unit index is the row, and vice versa, so (lines) doubles as the cells to keep.
+ */
+
+static uint8_t su_fish_apply(struct su_logic *logic,uint8_t base,uint16_t cover,uint16_t lines,uint16_t bit) {
+  uint8_t c=0,q=0;
+  for (;q<9;q++) {
+    if (!(cover&(1<<q))) continue;
+    c+=su_logic_eliminate(logic,base?(9+q):q,bit,0xff,lines);
+  }
+  return c;
+}
+
+static int8_t su_tech_fish(struct su_logic *logic,uint8_t n) {
+  uint8_t d=0; for (;d<9;d++) {
+    uint16_t bit=1<<d;
+    uint8_t base=0; for (;base<2;base++) {
+      uint16_t mv[9];
+      uint8_t lv[9],lc=0,i,j,k;
+      for (i=0;i<9;i++) {
+        mv[i]=0;
+        for (j=0;j<9;j++) {
+          uint8_t p=base?(j*9+i):(i*9+j);
+          if (logic->cand[p]&bit) mv[i]|=1<<j;
+        }
+        uint8_t c=su_popcount(mv[i]);
+        if ((c>=2)&&(c<=n)) lv[lc++]=i;
+      }
+      if (lc<n) continue;
+      for (i=0;i<lc;i++) {
+        for (j=i+1;j<lc;j++) {
+          uint16_t cover=mv[lv[i]]|mv[lv[j]];
+          uint16_t lines=(1<<lv[i])|(1<<lv[j]);
+          if (n==2) {
+            if (su_popcount(cover)!=2) continue;
+            if (su_fish_apply(logic,base,cover,lines,bit)) return 1;
+            continue;
+          }
+          if (su_popcount(cover)>n) continue;
+          for (k=j+1;k<lc;k++) {
+            uint16_t cover3=cover|mv[lv[k]];
+            if (su_popcount(cover3)!=n) continue;
+            if (su_fish_apply(logic,base,cover3,lines|(1<<lv[k]),bit)) return 1;
+          }
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+static int8_t su_tech_xwing(struct su_logic *logic) { return su_tech_fish(logic,2); }
+static int8_t su_tech_swordfish(struct su_logic *logic) { return su_tech_fish(logic,3); }
+
+/* XY-Wing: Pivot {a,b} sees pincers {a,c} and {b,c}.
+ * Whichever the pivot is, one pincer must be (c), so (c) goes from every cell seeing both pincers.
+ */
+
+static int8_t su_tech_xywing(struct su_logic *logic) {
+  uint8_t p=0; for (;p<81;p++) {
+    uint16_t pc=logic->cand[p];
+    if (su_popcount(pc)!=2) continue;
+    const uint8_t *peerv=su_peerv[p];
+    uint8_t i=0; for (;i<20;i++) {
+      uint8_t q1=peerv[i];
+      uint16_t c1=logic->cand[q1];
+      if (su_popcount(c1)!=2) continue;
+      uint16_t shared=c1&pc;
+      if (su_popcount(shared)!=1) continue;
+      uint16_t c=c1&~pc;
+      uint16_t want=(pc&~shared)|c;
+      uint8_t j=0; for (;j<20;j++) {
+        uint8_t q2=peerv[j];
+        if (logic->cand[q2]!=want) continue;
+        uint8_t changed=0;
+        const uint8_t *qv=su_peerv[q1];
+        uint8_t k=0; for (;k<20;k++) {
+          uint8_t r=qv[k];
+          if (!(logic->cand[r]&c)) continue;
+          if (!su_sees(r,q2)) continue;
+          logic->cand[r]&=~c;
+          changed=1;
+        }
+        if (changed) return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+/* Simple coloring.
+ * Units where a digit has exactly two positions link those cells: one or the other holds the digit.
+ * Alternate two colors along the links. Within one chain:
+ *  - Two cells of the same color seeing each other means that color is false everywhere.
+ *  - A cell off the chain that sees both colors can't hold the digit.
+ */
+
+static int8_t su_tech_coloring(struct su_logic *logic) {
+  uint8_t d=0; for (;d<9;d++) {
+    uint16_t bit=1<<d;
+    uint8_t color[81]={0}; // 0=none, else 2*chain+parity+1
+    uint8_t queue[81];
+    uint8_t chainc=0,p=0;
+    for (;p<81;p++) {
+      if (!(logic->cand[p]&bit)||color[p]) continue;
+      uint8_t base=chainc*2+1;
+      uint8_t qc=0,qp=0,chainlen=1;
+      color[p]=base;
+      queue[qc++]=p;
+      while (qp<qc) {
+        uint8_t a=queue[qp++];
+        uint8_t ui=0; for (;ui<3;ui++) {
+          const uint8_t *pv=su_unitv[su_cell_unitv[a][ui]];
+          uint8_t other=0xff,n=0,i=0;
+          for (;i<9;i++) {
+            if (!(logic->cand[pv[i]]&bit)) continue;
+            n++;
+            if (pv[i]!=a) other=pv[i];
+          }
+          if ((n!=2)||color[other]) continue;
+          color[other]=base+((color[a]-base)^1);
+          queue[qc++]=other;
+          chainlen++;
+        }
+      }
+      chainc++;
+      if (chainlen<3) continue;
+
+      // Color wrap.
+      uint8_t i,j;
+      for (i=0;i<qc;i++) {
+        for (j=i+1;j<qc;j++) {
+          if (color[queue[i]]!=color[queue[j]]) continue;
+          if (!su_sees(queue[i],queue[j])) continue;
+          uint8_t bad=color[queue[i]],k=0;
+          for (;k<qc;k++) if (color[queue[k]]==bad) logic->cand[queue[k]]&=~bit;
+          return 1;
+        }
+      }
+
+      // Color trap.
+      uint8_t changed=0,q=0;
+      for (;q<81;q++) {
+        if (!(logic->cand[q]&bit)||color[q]) continue;
+        uint8_t seen=0;
+        for (i=0;i<qc;i++) {
+          if (su_sees(q,queue[i])) seen|=1<<(color[queue[i]]-base);
+        }
+        if (seen==3) {
+          logic->cand[q]&=~bit;
+          changed=1;
+        }
+      }
+      if (changed) return 1;
+    }
+  }
+  return 0;
+}
+
+/* Technique table, in cost order.
+ * Tiers are drawn so each gets a fair share of the generator's output: Triples and fish are almost never
+ * the hardest thing a puzzle needs, so on their own they'd leave Hard nearly empty. Pairs fill it out.
+ */
+
+static const struct su_technique {
+  int8_t (*fn)(struct su_logic *logic);
+  uint8_t cost;
+  uint8_t tier;
+  const char *name;
+} su_techniquev[SU_TECH_COUNT]={
+  {su_tech_hidden_single, 1,SU_TIER_EASY,  "hidden_single"},
+  {su_tech_naked_single,  2,SU_TIER_EASY,  "naked_single"},
+  {su_tech_locked,        5,SU_TIER_MEDIUM,"locked_candidates"},
+  {su_tech_naked_pair,    8,SU_TIER_HARD,  "naked_pair"},
+  {su_tech_hidden_pair,  10,SU_TIER_HARD,  "hidden_pair"},
+  {su_tech_naked_triple, 12,SU_TIER_HARD,  "naked_triple"},
+  {su_tech_hidden_triple,14,SU_TIER_HARD,  "hidden_triple"},
+  {su_tech_xwing,        20,SU_TIER_HARD,  "x_wing"},
+  {su_tech_swordfish,    26,SU_TIER_HARD,  "swordfish"},
+  {su_tech_xywing,       30,SU_TIER_EXPERT,"xy_wing"},
+  {su_tech_coloring,     36,SU_TIER_EXPERT,"coloring"},
+};
+
+const char *su_technique_name(uint8_t tech) {
+  if (tech>=SU_TECH_COUNT) return "";
+  return su_techniquev[tech].name;
+}
+
+/* Rate, main entry point.
+ */
+
+uint8_t su_rate(struct su_rating *rating,const uint8_t *clues) {
+  memset(rating,0,sizeof(struct su_rating));
+  rating->tier=SU_TIER_EXPERT;
+  struct su_logic logic;
+  if (su_logic_load(&logic,clues)<0) return 0;
+
+  uint8_t hardest=0;
+  uint32_t score=0;
+  while (logic.blankc) {
+    int8_t c=0;
+    uint8_t tech=0;
+    for (;tech<SU_TECH_COUNT;tech++) {
+      if ((c=su_techniquev[tech].fn(&logic))) break;
+    }
+    if (c<0) return 0;
+    if (!c) break;
+    rating->techniques|=1<<tech;
+    if (rating->stepv[tech]+c>0xff) rating->stepv[tech]=0xff;
+    else rating->stepv[tech]+=c;
+    if (tech>hardest) hardest=tech;
+    if (su_techniquev[tech].tier>SU_TIER_EASY) score+=su_techniquev[tech].cost*c;
+  }
+
+  score+=su_techniquev[hardest].cost*10;
+  if (logic.blankc) {
+    score+=1000;
+  } else {
+    rating->solved=1;
+    rating->tier=su_techniquev[hardest].tier;
+  }
+  rating->score=(score>0xffff)?0xffff:score;
+  return rating->solved;
+}
+
+/* Hints.
+ * Same techniques, but stop as soon as some cell is down to a single, and report it instead of placing it.
+ * Returns 1 if found, 0 if not, or -1 on a contradiction.
+ */
+
+static int8_t su_logic_find_single(struct su_hint *hint,const struct su_logic *logic) {
+  uint16_t posv[9];
+  uint8_t u=0; for (;u<27;u++) {
+    uint16_t placed=su_logic_positions(posv,logic,u);
+    uint8_t d=0; for (;d<9;d++) {
+      if (placed&(1<<d)) continue;
+      uint16_t pos=posv[d];
+      if (!pos) return -1;
+      if (pos&(pos-1)) continue;
+      hint->p=su_unitv[u][su_mask_digit(pos)-1];
+      hint->digit=d+1;
+      hint->tech=SU_TECH_HIDDEN_SINGLE;
+      return 1;
+    }
+  }
+  uint8_t p=0; for (;p<81;p++) {
+    if (logic->value[p]) continue;
+    uint16_t cand=logic->cand[p];
+    if (!cand) return -1;
+    if (cand&(cand-1)) continue;
+    hint->p=p;
+    hint->digit=su_mask_digit(cand);
+    hint->tech=SU_TECH_NAKED_SINGLE;
+    return 1;
+  }
+  return 0;
+}
+
+static uint8_t su_hinter_fail(struct su_hinter *hinter) {
+  hinter->hint.p=0xff;
+  hinter->done=1;
+  return 1;
+}
+
+void su_hinter_begin(struct su_hinter *hinter,const uint8_t *grid) {
+  hinter->hint.p=0xff;
+  hinter->hint.digit=0;
+  hinter->hint.tech=0;
+  hinter->tech=0;
+  hinter->hardest=0;
+  hinter->done=(su_logic_load(&hinter->logic,grid)<0);
+}
+
+uint8_t su_hinter_step(struct su_hinter *hinter) {
+  if (hinter->done) return 1;
+  int8_t c;
+  if (!hinter->tech) {
+    if (!hinter->logic.blankc) return su_hinter_fail(hinter);
+    if ((c=su_logic_find_single(&hinter->hint,&hinter->logic))<0) return su_hinter_fail(hinter);
+    if (c) {
+      if (hinter->hardest>hinter->hint.tech) hinter->hint.tech=hinter->hardest;
+      hinter->done=1;
+      return 1;
+    }
+    hinter->tech=SU_TECH_LOCKED;
+    return 0;
+  }
+  if ((c=su_techniquev[hinter->tech].fn(&hinter->logic))<0) return su_hinter_fail(hinter);
+  if (c) {
+    if (hinter->tech>hinter->hardest) hinter->hardest=hinter->tech;
+    hinter->tech=0;
+    return 0;
+  }
+  if (++(hinter->tech)>=SU_TECH_COUNT) return su_hinter_fail(hinter);
+  return 0;
+}
+
+uint8_t su_hint(struct su_hint *hint,const uint8_t *grid) {
+  struct su_hinter hinter;
+  su_hinter_begin(&hinter,grid);
+  while (!su_hinter_step(&hinter)) ;
+  *hint=hinter.hint;
+  return (hint->p!=0xff);
+}
+
+/* Fill singles.
+ */
+
+int8_t su_fill_singles(uint8_t *grid) {
+  struct su_logic logic;
+  if (su_logic_load(&logic,grid)<0) return -1;
+  int8_t total=0;
+  while (1) {
+    int8_t c=su_tech_hidden_single(&logic);
+    if (!c) c=su_tech_naked_single(&logic);
+    if (c<0) return -1;
+    if (!c) break;
+    total+=c;
+  }
+  memcpy(grid,logic.value,81);
+  return total;
+}
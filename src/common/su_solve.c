@@ -0,0 +1,323 @@
+#include "platform.h"
+#include "sudoku.h"
+#include <string.h>
+
+#if BC_PLATFORM==BC_PLATFORM_tiny
+  #include <avr/pgmspace.h>
+#else
+  #define PROGMEM
+#endif
+
+/* Geometry tables.
+ * Peers are listed row first, then column, then whatever's left of the zone.
+ * Flash on the Tiny is memory-mapped, so these read like any other const; PROGMEM just keeps them out of RAM.
+ */
+ 
+const uint8_t su_unitv[27][9] PROGMEM={
+  {0,9,18,27,36,45,54,63,72},
+  {1,10,19,28,37,46,55,64,73},
+  {2,11,20,29,38,47,56,65,74},
+  {3,12,21,30,39,48,57,66,75},
+  {4,13,22,31,40,49,58,67,76},
+  {5,14,23,32,41,50,59,68,77},
+  {6,15,24,33,42,51,60,69,78},
+  {7,16,25,34,43,52,61,70,79},
+  {8,17,26,35,44,53,62,71,80},
+  {0,1,2,3,4,5,6,7,8},
+  {9,10,11,12,13,14,15,16,17},
+  {18,19,20,21,22,23,24,25,26},
+  {27,28,29,30,31,32,33,34,35},
+  {36,37,38,39,40,41,42,43,44},
+  {45,46,47,48,49,50,51,52,53},
+  {54,55,56,57,58,59,60,61,62},
+  {63,64,65,66,67,68,69,70,71},
+  {72,73,74,75,76,77,78,79,80},
+  {0,1,2,9,10,11,18,19,20},
+  {3,4,5,12,13,14,21,22,23},
+  {6,7,8,15,16,17,24,25,26},
+  {27,28,29,36,37,38,45,46,47},
+  {30,31,32,39,40,41,48,49,50},
+  {33,34,35,42,43,44,51,52,53},
+  {54,55,56,63,64,65,72,73,74},
+  {57,58,59,66,67,68,75,76,77},
+  {60,61,62,69,70,71,78,79,80},
+};
+
+const uint8_t su_cell_unitv[81][3] PROGMEM={
+  {0,9,18},{1,9,18},{2,9,18},{3,9,19},{4,9,19},{5,9,19},{6,9,20},{7,9,20},{8,9,20},
+  {0,10,18},{1,10,18},{2,10,18},{3,10,19},{4,10,19},{5,10,19},{6,10,20},{7,10,20},{8,10,20},
+  {0,11,18},{1,11,18},{2,11,18},{3,11,19},{4,11,19},{5,11,19},{6,11,20},{7,11,20},{8,11,20},
+  {0,12,21},{1,12,21},{2,12,21},{3,12,22},{4,12,22},{5,12,22},{6,12,23},{7,12,23},{8,12,23},
+  {0,13,21},{1,13,21},{2,13,21},{3,13,22},{4,13,22},{5,13,22},{6,13,23},{7,13,23},{8,13,23},
+  {0,14,21},{1,14,21},{2,14,21},{3,14,22},{4,14,22},{5,14,22},{6,14,23},{7,14,23},{8,14,23},
+  {0,15,24},{1,15,24},{2,15,24},{3,15,25},{4,15,25},{5,15,25},{6,15,26},{7,15,26},{8,15,26},
+  {0,16,24},{1,16,24},{2,16,24},{3,16,25},{4,16,25},{5,16,25},{6,16,26},{7,16,26},{8,16,26},
+  {0,17,24},{1,17,24},{2,17,24},{3,17,25},{4,17,25},{5,17,25},{6,17,26},{7,17,26},{8,17,26},
+};
+
+const uint8_t su_peerv[81][20] PROGMEM={
+  {1,2,3,4,5,6,7,8,9,18,27,36,45,54,63,72,10,11,19,20},
+  {0,2,3,4,5,6,7,8,10,19,28,37,46,55,64,73,9,11,18,20},
+  {0,1,3,4,5,6,7,8,11,20,29,38,47,56,65,74,9,10,18,19},
+  {0,1,2,4,5,6,7,8,12,21,30,39,48,57,66,75,13,14,22,23},
+  {0,1,2,3,5,6,7,8,13,22,31,40,49,58,67,76,12,14,21,23},
+  {0,1,2,3,4,6,7,8,14,23,32,41,50,59,68,77,12,13,21,22},
+  {0,1,2,3,4,5,7,8,15,24,33,42,51,60,69,78,16,17,25,26},
+  {0,1,2,3,4,5,6,8,16,25,34,43,52,61,70,79,15,17,24,26},
+  {0,1,2,3,4,5,6,7,17,26,35,44,53,62,71,80,15,16,24,25},
+  {10,11,12,13,14,15,16,17,0,18,27,36,45,54,63,72,1,2,19,20},
+  {9,11,12,13,14,15,16,17,1,19,28,37,46,55,64,73,0,2,18,20},
+  {9,10,12,13,14,15,16,17,2,20,29,38,47,56,65,74,0,1,18,19},
+  {9,10,11,13,14,15,16,17,3,21,30,39,48,57,66,75,4,5,22,23},
+  {9,10,11,12,14,15,16,17,4,22,31,40,49,58,67,76,3,5,21,23},
+  {9,10,11,12,13,15,16,17,5,23,32,41,50,59,68,77,3,4,21,22},
+  {9,10,11,12,13,14,16,17,6,24,33,42,51,60,69,78,7,8,25,26},
+  {9,10,11,12,13,14,15,17,7,25,34,43,52,61,70,79,6,8,24,26},
+  {9,10,11,12,13,14,15,16,8,26,35,44,53,62,71,80,6,7,24,25},
+  {19,20,21,22,23,24,25,26,0,9,27,36,45,54,63,72,1,2,10,11},
+  {18,20,21,22,23,24,25,26,1,10,28,37,46,55,64,73,0,2,9,11},
+  {18,19,21,22,23,24,25,26,2,11,29,38,47,56,65,74,0,1,9,10},
+  {18,19,20,22,23,24,25,26,3,12,30,39,48,57,66,75,4,5,13,14},
+  {18,19,20,21,23,24,25,26,4,13,31,40,49,58,67,76,3,5,12,14},
+  {18,19,20,21,22,24,25,26,5,14,32,41,50,59,68,77,3,4,12,13},
+  {18,19,20,21,22,23,25,26,6,15,33,42,51,60,69,78,7,8,16,17},
+  {18,19,20,21,22,23,24,26,7,16,34,43,52,61,70,79,6,8,15,17},
+  {18,19,20,21,22,23,24,25,8,17,35,44,53,62,71,80,6,7,15,16},
+  {28,29,30,31,32,33,34,35,0,9,18,36,45,54,63,72,37,38,46,47},
+  {27,29,30,31,32,33,34,35,1,10,19,37,46,55,64,73,36,38,45,47},
+  {27,28,30,31,32,33,34,35,2,11,20,38,47,56,65,74,36,37,45,46},
+  {27,28,29,31,32,33,34,35,3,12,21,39,48,57,66,75,40,41,49,50},
+  {27,28,29,30,32,33,34,35,4,13,22,40,49,58,67,76,39,41,48,50},
+  {27,28,29,30,31,33,34,35,5,14,23,41,50,59,68,77,39,40,48,49},
+  {27,28,29,30,31,32,34,35,6,15,24,42,51,60,69,78,43,44,52,53},
+  {27,28,29,30,31,32,33,35,7,16,25,43,52,61,70,79,42,44,51,53},
+  {27,28,29,30,31,32,33,34,8,17,26,44,53,62,71,80,42,43,51,52},
+  {37,38,39,40,41,42,43,44,0,9,18,27,45,54,63,72,28,29,46,47},
+  {36,38,39,40,41,42,43,44,1,10,19,28,46,55,64,73,27,29,45,47},
+  {36,37,39,40,41,42,43,44,2,11,20,29,47,56,65,74,27,28,45,46},
+  {36,37,38,40,41,42,43,44,3,12,21,30,48,57,66,75,31,32,49,50},
+  {36,37,38,39,41,42,43,44,4,13,22,31,49,58,67,76,30,32,48,50},
+  {36,37,38,39,40,42,43,44,5,14,23,32,50,59,68,77,30,31,48,49},
+  {36,37,38,39,40,41,43,44,6,15,24,33,51,60,69,78,34,35,52,53},
+  {36,37,38,39,40,41,42,44,7,16,25,34,52,61,70,79,33,35,51,53},
+  {36,37,38,39,40,41,42,43,8,17,26,35,53,62,71,80,33,34,51,52},
+  {46,47,48,49,50,51,52,53,0,9,18,27,36,54,63,72,28,29,37,38},
+  {45,47,48,49,50,51,52,53,1,10,19,28,37,55,64,73,27,29,36,38},
+  {45,46,48,49,50,51,52,53,2,11,20,29,38,56,65,74,27,28,36,37},
+  {45,46,47,49,50,51,52,53,3,12,21,30,39,57,66,75,31,32,40,41},
+  {45,46,47,48,50,51,52,53,4,13,22,31,40,58,67,76,30,32,39,41},
+  {45,46,47,48,49,51,52,53,5,14,23,32,41,59,68,77,30,31,39,40},
+  {45,46,47,48,49,50,52,53,6,15,24,33,42,60,69,78,34,35,43,44},
+  {45,46,47,48,49,50,51,53,7,16,25,34,43,61,70,79,33,35,42,44},
+  {45,46,47,48,49,50,51,52,8,17,26,35,44,62,71,80,33,34,42,43},
+  {55,56,57,58,59,60,61,62,0,9,18,27,36,45,63,72,64,65,73,74},
+  {54,56,57,58,59,60,61,62,1,10,19,28,37,46,64,73,63,65,72,74},
+  {54,55,57,58,59,60,61,62,2,11,20,29,38,47,65,74,63,64,72,73},
+  {54,55,56,58,59,60,61,62,3,12,21,30,39,48,66,75,67,68,76,77},
+  {54,55,56,57,59,60,61,62,4,13,22,31,40,49,67,76,66,68,75,77},
+  {54,55,56,57,58,60,61,62,5,14,23,32,41,50,68,77,66,67,75,76},
+  {54,55,56,57,58,59,61,62,6,15,24,33,42,51,69,78,70,71,79,80},
+  {54,55,56,57,58,59,60,62,7,16,25,34,43,52,70,79,69,71,78,80},
+  {54,55,56,57,58,59,60,61,8,17,26,35,44,53,71,80,69,70,78,79},
+  {64,65,66,67,68,69,70,71,0,9,18,27,36,45,54,72,55,56,73,74},
+  {63,65,66,67,68,69,70,71,1,10,19,28,37,46,55,73,54,56,72,74},
+  {63,64,66,67,68,69,70,71,2,11,20,29,38,47,56,74,54,55,72,73},
+  {63,64,65,67,68,69,70,71,3,12,21,30,39,48,57,75,58,59,76,77},
+  {63,64,65,66,68,69,70,71,4,13,22,31,40,49,58,76,57,59,75,77},
+  {63,64,65,66,67,69,70,71,5,14,23,32,41,50,59,77,57,58,75,76},
+  {63,64,65,66,67,68,70,71,6,15,24,33,42,51,60,78,61,62,79,80},
+  {63,64,65,66,67,68,69,71,7,16,25,34,43,52,61,79,60,62,78,80},
+  {63,64,65,66,67,68,69,70,8,17,26,35,44,53,62,80,60,61,78,79},
+  {73,74,75,76,77,78,79,80,0,9,18,27,36,45,54,63,55,56,64,65},
+  {72,74,75,76,77,78,79,80,1,10,19,28,37,46,55,64,54,56,63,65},
+  {72,73,75,76,77,78,79,80,2,11,20,29,38,47,56,65,54,55,63,64},
+  {72,73,74,76,77,78,79,80,3,12,21,30,39,48,57,66,58,59,67,68},
+  {72,73,74,75,77,78,79,80,4,13,22,31,40,49,58,67,57,59,66,68},
+  {72,73,74,75,76,78,79,80,5,14,23,32,41,50,59,68,57,58,66,67},
+  {72,73,74,75,76,77,79,80,6,15,24,33,42,51,60,69,61,62,70,71},
+  {72,73,74,75,76,77,78,80,7,16,25,34,43,52,61,70,60,62,69,71},
+  {72,73,74,75,76,77,78,79,8,17,26,35,44,53,62,71,60,61,69,70},
+};
+
+/* Init.
+ */
+ 
+void su_solver_init(struct su_solver *solver) {
+  memset(solver->value,0,81);
+  memset(solver->used,0,sizeof(solver->used));
+  solver->trailc=0;
+  solver->conflict=0;
+  solver->limit=0;
+  solver->count=0;
+  #if SU_STATS
+    solver->stats=0;
+  #endif
+}
+
+/* Load clues.
+ */
+ 
+int8_t su_solver_load(struct su_solver *solver,const uint8_t *src) {
+  su_solver_init(solver);
+  int8_t result=0;
+  uint8_t p=0; for (;p<81;p++) {
+    if (!src[p]) continue;
+    if (su_solver_place(solver,p,src[p])<0) result=-1;
+  }
+  solver->conflict=(result<0);
+  return result;
+}
+
+/* Place and undo.
+ */
+ 
+int8_t su_solver_place(struct su_solver *solver,uint8_t p,uint8_t digit) {
+  if ((digit<1)||(digit>9)) return -1;
+  uint16_t bit=1<<(digit-1);
+  if (!(su_solver_candidates(solver,p)&bit)) return -1;
+  const uint8_t *u=su_cell_unitv[p];
+  solver->used[u[0]]|=bit;
+  solver->used[u[1]]|=bit;
+  solver->used[u[2]]|=bit;
+  solver->value[p]=digit;
+  solver->trail[solver->trailc++]=p;
+  return 0;
+}
+
+void su_solver_undo(struct su_solver *solver,uint8_t mark) {
+  while (solver->trailc>mark) {
+    uint8_t p=solver->trail[--(solver->trailc)];
+    uint16_t mask=~(1<<(solver->value[p]-1));
+    const uint8_t *u=su_cell_unitv[p];
+    solver->used[u[0]]&=mask;
+    solver->used[u[1]]&=mask;
+    solver->used[u[2]]&=mask;
+    solver->value[p]=0;
+  }
+}
+
+void su_solver_remove(struct su_solver *solver,uint8_t p) {
+  if (!solver->value[p]) return;
+  uint16_t mask=~(1<<(solver->value[p]-1));
+  const uint8_t *u=su_cell_unitv[p];
+  solver->used[u[0]]&=mask;
+  solver->used[u[1]]&=mask;
+  solver->used[u[2]]&=mask;
+  solver->value[p]=0;
+  uint8_t i=0; for (;i<solver->trailc;i++) {
+    if (solver->trail[i]!=p) continue;
+    solver->trailc--;
+    memmove(solver->trail+i,solver->trail+i+1,solver->trailc-i);
+    break;
+  }
+}
+
+/* Propagate singles.
+ */
+ 
+static int8_t su_solver_naked_singles(struct su_solver *solver) {
+  int8_t placec=0;
+  uint8_t p=0; for (;p<81;p++) {
+    if (solver->value[p]) continue;
+    uint16_t cand=su_solver_candidates(solver,p);
+    if (!cand) return -1;
+    if (cand&(cand-1)) continue;
+    su_solver_place(solver,p,su_mask_digit(cand));
+    placec++;
+  }
+  return placec;
+}
+
+static int8_t su_solver_hidden_singles(struct su_solver *solver) {
+  int8_t placec=0;
+  uint8_t ui=0; for (;ui<27;ui++) {
+    uint16_t need=~solver->used[ui]&SU_ALL;
+    if (!need) continue;
+    const uint8_t *pv=su_unitv[ui];
+    uint16_t candv[9],twice;
+    uint8_t i=0; for (;i<9;i++) candv[i]=su_solver_candidates(solver,pv[i]);
+    uint16_t once=su_kernel_once_twice(&twice,candv,9);
+    if (need&~once) return -1; // Some digit has nowhere to go.
+    uint16_t single=once&~twice;
+    while (single) {
+      uint16_t bit=single&-single;
+      single&=~bit;
+      for (i=0;i<9;i++) {
+        if (!(su_solver_candidates(solver,pv[i])&bit)) continue;
+        if (su_solver_place(solver,pv[i],su_mask_digit(bit))<0) return -1;
+        placec++;
+        break;
+      }
+      if (i>=9) return -1; // Lost its only home to an earlier placement in this pass.
+    }
+  }
+  return placec;
+}
+ 
+int8_t su_solver_propagate(struct su_solver *solver) {
+  int8_t total=0;
+  while (1) {
+    int8_t c=su_solver_naked_singles(solver);
+    if (c<0) return -1;
+    if (!c) {
+      if ((c=su_solver_hidden_singles(solver))<0) return -1;
+      if (!c) return total;
+    }
+    SU_STAT(solver->stats,propagations,c)
+    total+=c;
+  }
+}
+
+/* Count solutions.
+ * Propagate singles, then branch on the blank cell with the fewest candidates.
+ */
+ 
+static void su_solver_search(struct su_solver *solver) {
+  uint8_t mark=solver->trailc;
+  if (su_solver_propagate(solver)<0) {
+    SU_STAT(solver->stats,backtracks,1)
+    su_solver_undo(solver,mark);
+    return;
+  }
+  uint8_t bestp=0xff,bestc=10,p=0;
+  for (;p<81;p++) {
+    if (solver->value[p]) continue;
+    uint8_t c=su_popcount(su_solver_candidates(solver,p));
+    if (c<bestc) {
+      bestp=p;
+      bestc=c;
+      if (c<=2) break;
+    }
+  }
+  if (bestp==0xff) {
+    if (!solver->count++) memcpy(solver->solution,solver->value,81);
+    su_solver_undo(solver,mark);
+    return;
+  }
+  uint16_t cand=su_solver_candidates(solver,bestp);
+  uint8_t inner=solver->trailc;
+  while (cand&&(solver->count<solver->limit)) {
+    uint16_t bit=cand&-cand;
+    cand&=~bit;
+    SU_STAT(solver->stats,guesses,1)
+    su_solver_place(solver,bestp,su_mask_digit(bit));
+    su_solver_search(solver);
+    su_solver_undo(solver,inner);
+  }
+  su_solver_undo(solver,mark);
+}
+ 
+uint32_t su_solver_count(struct su_solver *solver,uint32_t limit) {
+  solver->limit=limit;
+  solver->count=0;
+  if (limit&&!solver->conflict) su_solver_search(solver);
+  return solver->count;
+}
+
+uint32_t su_count(uint8_t *solution,const uint8_t *clues,uint32_t limit) {
+  struct su_solver solver;
+  if (su_solver_load(&solver,clues)<0) return 0;
+  uint32_t count=su_solver_count(&solver,limit);
+  if (count&&solution) memcpy(solution,solver.solution,81);
+  return count;
+}
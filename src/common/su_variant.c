@@ -0,0 +1,275 @@
+#include "sudoku.h"
+#include <string.h>
+
+/* Setup, one unit at a time.
+ */
+
+static void su_vsolver_add_unit(struct su_vsolver *solver,const uint8_t *cellv,uint8_t cellc) {
+  uint8_t u=solver->unitc++;
+  memcpy(solver->unitv[u],cellv,cellc);
+  solver->unit_cellc[u]=cellc;
+  uint8_t i=0; for (;i<cellc;i++) {
+    uint8_t p=cellv[i];
+    solver->cell_unitv[p][solver->cell_unitc[p]++]=u;
+  }
+}
+
+// Every set of (cellc) distinct digits summing to (sum).
+static int8_t su_vsolver_add_combos(struct su_vsolver *solver,uint8_t cage,uint8_t cellc,uint8_t sum) {
+  uint16_t c=solver->combop[cage];
+  uint16_t mask=1; for (;mask<=SU_ALL;mask++) {
+    if (su_popcount(mask)!=cellc) continue;
+    uint8_t total=0,d=1;
+    uint16_t m=mask; for (;m;m>>=1,d++) if (m&1) total+=d;
+    if (total!=sum) continue;
+    if (c>=SU_VARIANT_COMBO_LIMIT) return -1;
+    solver->combov[c++]=mask;
+  }
+  if (c==solver->combop[cage]) return -1;
+  solver->combop[cage+1]=c;
+  return 0;
+}
+
+int8_t su_vsolver_setup(struct su_vsolver *solver,const struct su_variant *variant) {
+  solver->unitc=0;
+  memset(solver->cell_unitc,0,sizeof(solver->cell_unitc));
+  memset(solver->cell_cagev,0xff,sizeof(solver->cell_cagev));
+
+  // Columns and rows always. Zones, or the jigsaw's regions.
+  uint8_t u=0; for (;u<18;u++) su_vsolver_add_unit(solver,su_unitv[u],9);
+  if (variant->regionv) {
+    uint8_t regionv[9][9],regioncv[9]={0};
+    uint8_t p=0; for (;p<81;p++) {
+      uint8_t r=variant->regionv[p];
+      if ((r>=9)||(regioncv[r]>=9)) return -1;
+      regionv[r][regioncv[r]++]=p;
+    }
+    for (u=0;u<9;u++) su_vsolver_add_unit(solver,regionv[u],9);
+  } else {
+    for (u=18;u<27;u++) su_vsolver_add_unit(solver,su_unitv[u],9);
+  }
+
+  if (variant->flags&SU_VARIANT_DIAGONAL) {
+    uint8_t diagv[9],antiv[9];
+    uint8_t i=0; for (;i<9;i++) {
+      diagv[i]=i*10;
+      antiv[i]=i*8+8;
+    }
+    su_vsolver_add_unit(solver,diagv,9);
+    su_vsolver_add_unit(solver,antiv,9);
+  }
+
+  solver->cagebase=solver->unitc;
+  solver->combop[0]=0;
+  if (variant->cagec>SU_VARIANT_CAGE_LIMIT) return -1;
+  uint8_t i=0; for (;i<variant->cagec;i++) {
+    const struct su_cage *cage=variant->cagev+i;
+    if ((cage->cellc<1)||(cage->cellc>9)) return -1;
+    uint8_t j=0; for (;j<cage->cellc;j++) {
+      uint8_t p=cage->cellv[j];
+      if ((p>=81)||(solver->cell_cagev[p]!=0xff)) return -1;
+      solver->cell_cagev[p]=solver->unitc;
+    }
+    if (su_vsolver_add_combos(solver,i,cage->cellc,cage->sum)<0) return -1;
+    su_vsolver_add_unit(solver,cage->cellv,cage->cellc);
+  }
+
+  su_vsolver_load(solver,0);
+  return 0;
+}
+
+/* Load.
+ */
+
+int8_t su_vsolver_load(struct su_vsolver *solver,const uint8_t *src) {
+  memset(solver->value,0,81);
+  memset(solver->used,0,sizeof(solver->used));
+  solver->trailc=0;
+  solver->conflict=0;
+  solver->limit=0;
+  solver->count=0;
+  if (!src) return 0;
+  int8_t result=0;
+  uint8_t p=0; for (;p<81;p++) {
+    if (!src[p]) continue;
+    if (su_vsolver_place(solver,p,src[p])<0) result=-1;
+  }
+  solver->conflict=(result<0);
+  return result;
+}
+
+/* Cages.
+ * (allow) is every digit some consistent set could still add, and (need) the digits every such set still needs.
+ */
+
+static void su_vsolver_cage(uint16_t *allow,uint16_t *need,const struct su_vsolver *solver,uint8_t u) {
+  uint16_t used=solver->used[u];
+  uint8_t cage=u-solver->cagebase;
+  const uint16_t *combo=solver->combov+solver->combop[cage];
+  const uint16_t *end=solver->combov+solver->combop[cage+1];
+  *allow=0;
+  *need=SU_ALL;
+  for (;combo<end;combo++) {
+    if (((*combo)&used)!=used) continue;
+    *allow|=*combo;
+    *need&=*combo;
+  }
+  *allow&=~used;
+  *need&=*allow; // Stays zero if nothing fits, which shows up as a cell with no candidates.
+}
+
+/* Candidates.
+ */
+
+uint16_t su_vsolver_candidates(const struct su_vsolver *solver,uint8_t p) {
+  if (solver->value[p]) return 0;
+  const uint8_t *u=solver->cell_unitv[p];
+  uint16_t used=0;
+  uint8_t i=solver->cell_unitc[p]; while (i-->0) used|=solver->used[u[i]];
+  uint16_t cand=~used&SU_ALL;
+  if (solver->cell_cagev[p]!=0xff) {
+    uint16_t allow,need;
+    su_vsolver_cage(&allow,&need,solver,solver->cell_cagev[p]);
+    cand&=allow;
+  }
+  return cand;
+}
+
+/* Place and undo.
+ */
+
+int8_t su_vsolver_place(struct su_vsolver *solver,uint8_t p,uint8_t digit) {
+  if ((digit<1)||(digit>9)) return -1;
+  uint16_t bit=1<<(digit-1);
+  if (!(su_vsolver_candidates(solver,p)&bit)) return -1;
+  const uint8_t *u=solver->cell_unitv[p];
+  uint8_t i=solver->cell_unitc[p]; while (i-->0) solver->used[u[i]]|=bit;
+  solver->value[p]=digit;
+  solver->trail[solver->trailc++]=p;
+  return 0;
+}
+
+void su_vsolver_undo(struct su_vsolver *solver,uint8_t mark) {
+  while (solver->trailc>mark) {
+    uint8_t p=solver->trail[--(solver->trailc)];
+    uint16_t mask=~(1<<(solver->value[p]-1));
+    const uint8_t *u=solver->cell_unitv[p];
+    uint8_t i=solver->cell_unitc[p]; while (i-->0) solver->used[u[i]]&=mask;
+    solver->value[p]=0;
+  }
+}
+
+/* Propagate singles.
+ * Hidden singles look at the digits each unit needs: All of them for 9-cell units, and for cages, whatever every consistent set has.
+ */
+
+static int8_t su_vsolver_naked_singles(struct su_vsolver *solver) {
+  int8_t placec=0;
+  uint8_t p=0; for (;p<81;p++) {
+    if (solver->value[p]) continue;
+    uint16_t cand=su_vsolver_candidates(solver,p);
+    if (!cand) return -1;
+    if (cand&(cand-1)) continue;
+    if (su_vsolver_place(solver,p,su_mask_digit(cand))<0) return -1;
+    placec++;
+  }
+  return placec;
+}
+
+static int8_t su_vsolver_hidden_singles(struct su_vsolver *solver) {
+  int8_t placec=0;
+  uint8_t ui=0; for (;ui<solver->unitc;ui++) {
+    uint16_t need;
+    if (ui<solver->cagebase) {
+      need=~solver->used[ui]&SU_ALL;
+    } else {
+      uint16_t allow;
+      su_vsolver_cage(&allow,&need,solver,ui);
+    }
+    if (!need) continue;
+    const uint8_t *pv=solver->unitv[ui];
+    uint8_t cellc=solver->unit_cellc[ui];
+    uint16_t candv[9],twice;
+    uint8_t i=0; for (;i<cellc;i++) candv[i]=su_vsolver_candidates(solver,pv[i]);
+    uint16_t once=su_kernel_once_twice(&twice,candv,cellc);
+    if (need&~once) return -1;
+    uint16_t single=need&once&~twice;
+    while (single) {
+      uint16_t bit=single&-single;
+      single&=~bit;
+      for (i=0;i<cellc;i++) {
+        if (!(su_vsolver_candidates(solver,pv[i])&bit)) continue;
+        if (su_vsolver_place(solver,pv[i],su_mask_digit(bit))<0) return -1;
+        placec++;
+        break;
+      }
+      if (i>=cellc) return -1;
+    }
+  }
+  return placec;
+}
+
+int8_t su_vsolver_propagate(struct su_vsolver *solver) {
+  int8_t total=0;
+  while (1) {
+    int8_t c=su_vsolver_naked_singles(solver);
+    if (c<0) return -1;
+    if (!c) {
+      if ((c=su_vsolver_hidden_singles(solver))<0) return -1;
+      if (!c) return total;
+    }
+    total+=c;
+  }
+}
+
+/* Count solutions.
+ */
+
+static void su_vsolver_search(struct su_vsolver *solver) {
+  uint8_t mark=solver->trailc;
+  if (su_vsolver_propagate(solver)<0) {
+    su_vsolver_undo(solver,mark);
+    return;
+  }
+  uint8_t bestp=0xff,bestc=10,p=0;
+  for (;p<81;p++) {
+    if (solver->value[p]) continue;
+    uint8_t c=su_popcount(su_vsolver_candidates(solver,p));
+    if (c<bestc) {
+      bestp=p;
+      bestc=c;
+      if (c<=2) break;
+    }
+  }
+  if (bestp==0xff) {
+    if (!solver->count++) memcpy(solver->solution,solver->value,81);
+    su_vsolver_undo(solver,mark);
+    return;
+  }
+  uint16_t cand=su_vsolver_candidates(solver,bestp);
+  uint8_t inner=solver->trailc;
+  while (cand&&(solver->count<solver->limit)) {
+    uint16_t bit=cand&-cand;
+    cand&=~bit;
+    su_vsolver_place(solver,bestp,su_mask_digit(bit));
+    su_vsolver_search(solver);
+    su_vsolver_undo(solver,inner);
+  }
+  su_vsolver_undo(solver,mark);
+}
+
+uint32_t su_vsolver_count(struct su_vsolver *solver,uint32_t limit) {
+  solver->limit=limit;
+  solver->count=0;
+  if (limit&&!solver->conflict) su_vsolver_search(solver);
+  return solver->count;
+}
+
+uint32_t su_variant_count(uint8_t *solution,const struct su_variant *variant,const uint8_t *clues,uint32_t limit) {
+  struct su_vsolver solver;
+  if (su_vsolver_setup(&solver,variant)<0) return 0;
+  if (su_vsolver_load(&solver,clues)<0) return 0;
+  uint32_t count=su_vsolver_count(&solver,limit);
+  if (count&&solution) memcpy(solution,solver.solution,81);
+  return count;
+}
@@ -0,0 +1,428 @@
+/* sudoku.h
+ * Solver core shared by the generator, the game, and tools.
+ * Grids are 81 bytes, row-major, 0 for blank or 1..9.
+ * Candidates are 9-bit masks: 0x001 is digit 1, 0x100 is digit 9.
+ */
+
+#ifndef SUDOKU_H
+#define SUDOKU_H
+
+#include <stdint.h>
+#include "platform.h"
+
+#define SU_ALL 0x1ff
+
+/* Statistics.
+ * Counters for tuning the generator and solver. SU_STATS=0 compiles them out entirely, and that's the default for the Tiny.
+ * The struct and su_generator_stats() exist either way; without SU_STATS they report zeros.
+ *********************************************************************/
+
+#ifndef SU_STATS
+  #if BC_PLATFORM==BC_PLATFORM_tiny
+    #define SU_STATS 0
+  #else
+    #define SU_STATS 1
+  #endif
+#endif
+
+struct su_stats {
+  // Bitboard solver, only where it's working for the generator:
+  uint32_t propagations; // Cells placed by naked or hidden singles.
+  uint32_t guesses; // Branches tried in search.
+  uint32_t backtracks; // Dead ends, in search or fill.
+  // Generator:
+  uint32_t eliminations; // Cells narrowed by subgroup logic during exposure.
+  uint32_t trials; // Clues we tried removing.
+  uint32_t searches; // ...of which needed a uniqueness search (the rest were forced singles).
+  uint32_t contradictions; // Exposure left a cell with no possibilities. Shouldn't happen; each is also a restart.
+  uint16_t fills,passes,restarts; // Same as su_generator (fillc,repc,retryc).
+  // Wall time per phase, in nanoseconds:
+  uint64_t fill_ns,expose_ns,reduce_ns,rate_ns;
+};
+
+#if SU_STATS
+  #define SU_STAT(stats,field,n) { if (stats) (stats)->field+=(n); }
+#else
+  #define SU_STAT(stats,field,n)
+#endif
+
+/* Geometry.
+ * Units are numbered the same way the generator has always numbered its axes:
+ * columns 0..8, rows 9..17, zones 18..26.
+ *********************************************************************/
+
+extern const uint8_t su_unitv[27][9]; // Cells of each unit.
+extern const uint8_t su_cell_unitv[81][3]; // (col,row,zone) unit ids for each cell.
+extern const uint8_t su_peerv[81][20]; // Every cell sharing a unit with this one, not including itself.
+
+static inline uint8_t su_popcount(uint16_t mask) { return __builtin_popcount(mask); }
+
+// Lowest digit 1..9 in (mask), or 0 if empty.
+static inline uint8_t su_mask_digit(uint16_t mask) { return mask?(__builtin_ctz(mask)+1):0; }
+
+/* Mask kernels.
+ * Bulk operations on arrays of candidate masks, vectorized where the platform allows (see su_kernel.c).
+ * Arrays needn't be aligned. Results are identical on every platform.
+ **********************************************************************/
+
+const char *su_kernel_name(); // "sse2", "neon", or "portable"
+
+/* Look at (v[0..c-1]&SU_ALL) in order, up to the first that isn't a single bit.
+ * 1 if there isn't one, 0 if it has several bits, -1 if it's empty.
+ */
+int8_t su_kernel_singles(const uint16_t *v,uint8_t c);
+
+// How many of (v[0..c-1]) have no bits outside (mask).
+uint8_t su_kernel_count_within(const uint16_t *v,uint8_t c,uint16_t mask);
+
+// Nine cells' candidates (v) to nine digits' positions (posv): Bit (i) of posv[d] is bit (d) of v[i].
+void su_kernel_positions(uint16_t *posv,const uint16_t *v);
+
+// OR of (v[0..c-1]) as the return value, and in (twice), the bits set in more than one of them.
+uint16_t su_kernel_once_twice(uint16_t *twice,const uint16_t *v,uint8_t c);
+
+/* Bitboard solver.
+ * Tracks which digits are used in each unit; a cell's candidates are whatever its three units leave open.
+ * Every placement is recorded in (trail), so you can roll back to any earlier (trailc) with su_solver_undo().
+ * Recursion is no deeper than the count of blank cells, and frames are small; this is safe to run on the Tiny.
+ **********************************************************************/
+
+struct su_solver {
+  uint8_t value[81];
+  uint16_t used[27]; // Digits placed in each unit, indexed like su_unitv.
+  uint8_t trail[81]; // Cells placed since init, in order.
+  uint8_t trailc;
+  uint8_t conflict; // Set by su_solver_load() if clues conflicted. Then there's nothing to count.
+  uint32_t limit; // Stop searching at so many solutions.
+  uint32_t count; // Solutions found so far.
+  uint8_t solution[81]; // First solution found.
+  #if SU_STATS
+    struct su_stats *stats; // Optional, for the owner to set after init or load.
+  #endif
+};
+
+void su_solver_init(struct su_solver *solver);
+
+/* Init and place each nonzero digit of (src).
+ * <0 if two clues conflict. Then the conflicting clue isn't placed, but (conflict) is set,
+ * and su_solver_count() finds no solutions until the next init or load.
+ */
+int8_t su_solver_load(struct su_solver *solver,const uint8_t *src);
+
+static inline uint16_t su_solver_candidates(const struct su_solver *solver,uint8_t p) {
+  if (solver->value[p]) return 0;
+  const uint8_t *u=su_cell_unitv[p];
+  return ~(solver->used[u[0]]|solver->used[u[1]]|solver->used[u[2]])&SU_ALL;
+}
+
+/* Set one blank cell. <0 if (digit) is already used by a neighbor.
+ */
+int8_t su_solver_place(struct su_solver *solver,uint8_t p,uint8_t digit);
+
+/* Roll back placements until (trailc) is at most (mark).
+ */
+void su_solver_undo(struct su_solver *solver,uint8_t mark);
+
+/* Clear one placed cell, wherever it is in the trail.
+ * For when you're removing clues one at a time; the rest of the state stays put, so no need to reload.
+ */
+void su_solver_remove(struct su_solver *solver,uint8_t p);
+
+/* Apply naked and hidden singles until nothing changes.
+ * Returns the count of cells placed, or <0 if the grid became inconsistent.
+ * We do not undo on failure; note (trailc) first if you need to.
+ */
+int8_t su_solver_propagate(struct su_solver *solver);
+
+/* Count solutions, stopping at (limit).
+ * The first solution found lands in (solver->solution).
+ * Grid state is restored before returning.
+ */
+uint32_t su_solver_count(struct su_solver *solver,uint32_t limit);
+
+/* Convenience for one-off checks, with the solver on the stack.
+ * (solution) is optional, receives the first solution found.
+ */
+uint32_t su_count(uint8_t *solution,const uint8_t *clues,uint32_t limit);
+
+/* Variant solver.
+ * Same algorithm as su_solver, but units come from tables built once per puzzle instead of su_cell_unitv:
+ *   Units 0..26 as usual, except a jigsaw replaces zones 18..26 with its own regions.
+ *   Then the two diagonals if SU_VARIANT_DIAGONAL, 27 top-left to bottom-right and 28 top-right to bottom-left.
+ *   Then one unit per killer cage. Digits don't repeat within a cage, and must sum to its target.
+ * Each cage keeps the digit sets that could fill it (eg 3 in 2 cells: {1,2}), and a cell's candidates
+ * are limited to the union of the sets still consistent with the cage's placed digits.
+ * Classic puzzles should keep using su_solver; nothing here touches it.
+ **********************************************************************/
+
+#define SU_VARIANT_DIAGONAL 0x01
+
+#define SU_VARIANT_CAGE_LIMIT 81
+#define SU_VARIANT_UNIT_LIMIT (29+SU_VARIANT_CAGE_LIMIT)
+#define SU_VARIANT_CELL_UNIT_LIMIT 6 /* column, row, zone, two diagonals at the center, cage */
+#define SU_VARIANT_COMBO_LIMIT 256 /* digit sets across all cages; 81 cells can't need more than 243 */
+
+struct su_cage {
+  uint8_t sum;
+  uint8_t cellc; // 1..9
+  uint8_t cellv[9];
+};
+
+struct su_variant {
+  uint8_t flags; // SU_VARIANT_*
+  const uint8_t *regionv; // Optional, jigsaw: Region 0..8 for each of 81 cells, 9 cells each.
+  const struct su_cage *cagev; // Optional, killer. A cell may belong to at most one cage.
+  uint8_t cagec;
+};
+
+struct su_vsolver {
+  // Tables, from su_vsolver_setup():
+  uint8_t unitc;
+  uint8_t cagebase; // Unit id of the first cage. Units below it have 9 cells and need every digit.
+  uint8_t unitv[SU_VARIANT_UNIT_LIMIT][9];
+  uint8_t unit_cellc[SU_VARIANT_UNIT_LIMIT];
+  uint8_t cell_unitv[81][SU_VARIANT_CELL_UNIT_LIMIT];
+  uint8_t cell_unitc[81];
+  uint8_t cell_cagev[81]; // Unit id of each cell's cage, or 0xff.
+  uint16_t combov[SU_VARIANT_COMBO_LIMIT]; // Possible digit sets, grouped by cage.
+  uint16_t combop[SU_VARIANT_CAGE_LIMIT+1]; // Cage (i) owns combov[combop[i]..combop[i+1]-1].
+  // State, as in su_solver:
+  uint8_t value[81];
+  uint16_t used[SU_VARIANT_UNIT_LIMIT];
+  uint8_t trail[81];
+  uint8_t trailc;
+  uint8_t conflict;
+  uint32_t limit;
+  uint32_t count;
+  uint8_t solution[81];
+};
+
+/* Build the unit tables and clear the grid. <0 if (variant) is malformed:
+ * Regions not 9 cells each, cages overlapping or out of range, or a cage sum no digits can make.
+ */
+int8_t su_vsolver_setup(struct su_vsolver *solver,const struct su_variant *variant);
+
+// Clear the grid and place each nonzero digit of (src). Tables stay.
+// <0 if clues conflict, and then su_vsolver_count() finds nothing until the next load, same as su_solver.
+int8_t su_vsolver_load(struct su_vsolver *solver,const uint8_t *src);
+
+uint16_t su_vsolver_candidates(const struct su_vsolver *solver,uint8_t p);
+int8_t su_vsolver_place(struct su_vsolver *solver,uint8_t p,uint8_t digit);
+void su_vsolver_undo(struct su_vsolver *solver,uint8_t mark);
+int8_t su_vsolver_propagate(struct su_vsolver *solver);
+uint32_t su_vsolver_count(struct su_vsolver *solver,uint32_t limit);
+
+/* su_count() for variants. Returns 0 if (variant) is malformed too.
+ * The solver is about 3 kB, on the stack.
+ */
+uint32_t su_variant_count(uint8_t *solution,const struct su_variant *variant,const uint8_t *clues,uint32_t limit);
+
+/* Backends.
+ * Every solver backend offers a counter with the same shape as su_count(), so callers can swap them.
+ **********************************************************************/
+
+typedef uint32_t (*su_count_fn)(uint8_t *solution,const uint8_t *clues,uint32_t limit);
+
+/* Dancing links, Knuth's Algorithm X over the 324-column exact-cover matrix.
+ * Native only: the node arena is about 40 kB, more than the Tiny has.
+ * Each thread gets its own arena, built on first use and restored after every call. No allocation.
+ */
+uint32_t su_dlx_count(uint8_t *solution,const uint8_t *clues,uint32_t limit);
+
+/* Difficulty rater.
+ * A logical solver that tries techniques cheapest first, restarting from the top after each step.
+ * Singles count one step per cell placed; other techniques count one step per application.
+ **********************************************************************/
+
+#define SU_TECH_HIDDEN_SINGLE   0
+#define SU_TECH_NAKED_SINGLE    1
+#define SU_TECH_LOCKED          2 /* pointing and claiming */
+#define SU_TECH_NAKED_PAIR      3
+#define SU_TECH_HIDDEN_PAIR     4
+#define SU_TECH_NAKED_TRIPLE    5
+#define SU_TECH_HIDDEN_TRIPLE   6
+#define SU_TECH_XWING           7
+#define SU_TECH_SWORDFISH       8
+#define SU_TECH_XYWING          9
+#define SU_TECH_COLORING       10
+#define SU_TECH_COUNT          11
+
+#define SU_TIER_EASY    0 /* singles only */
+#define SU_TIER_MEDIUM  1 /* locked candidates */
+#define SU_TIER_HARD    2 /* pairs, triples, fish */
+#define SU_TIER_EXPERT  3 /* wings, coloring, or our techniques stalled */
+#define SU_TIER_COUNT   4
+
+/* Of the generator's output, roughly 43% rates Easy, 11% Medium, 7% Hard, and 9% Expert.
+ * The other 30% stalls: Our techniques can't finish it, so neither can hints. Those rate Expert with (solved) zero,
+ * and the puzzle bank and the game's pool leave them out.
+ */
+
+struct su_rating {
+  uint16_t score; // 10 * cost of the hardest technique, plus cost of each step beyond singles. +1000 if stalled.
+  uint16_t techniques; // (1<<SU_TECH_*) for each technique used
+  uint8_t stepv[SU_TECH_COUNT]; // Steps taken per technique, saturating at 255.
+  uint8_t tier; // SU_TIER_*
+  uint8_t solved; // Nonzero if techniques alone solved it.
+};
+
+/* Rate the puzzle in (clues), 81 digits 0..9.
+ * Returns (rating->solved). Zero can also mean the clues are inconsistent.
+ */
+uint8_t su_rate(struct su_rating *rating,const uint8_t *clues);
+
+const char *su_technique_name(uint8_t tech);
+
+/* Logical solver state, shared by the rater and hints.
+ * Unlike su_solver, we keep explicit candidates per cell, since most techniques only eliminate.
+ */
+struct su_logic {
+  uint16_t cand[81]; // zero for filled cells
+  uint8_t value[81];
+  uint8_t blankc;
+};
+
+/* Hints, with the rater's techniques, on a board in progress.
+ * (grid) is 81 digits 0..9, whatever the player has entered so far. We don't know the true solution, and don't need it.
+ * We look for the next cell that logic can fill: Singles first, and the cheapest technique that unlocks one otherwise.
+ * su_hint() returns nonzero with (hint) filled in, or zero if (grid) contradicts itself or our techniques stall.
+ * (hint->tech) is the hardest technique needed on the way.
+ */
+struct su_hint {
+  uint8_t p; // 0..80, or 0xff if none.
+  uint8_t digit; // 1..9
+  uint8_t tech; // SU_TECH_*
+};
+uint8_t su_hint(struct su_hint *hint,const uint8_t *grid);
+
+/* Same thing in small pieces, if you can't afford to block: Each step is one technique pass.
+ * su_hinter_step() returns nonzero when it's done, and then (hinter->hint) is the answer, with (p) 0xff if none.
+ */
+struct su_hinter {
+  struct su_logic logic;
+  struct su_hint hint;
+  uint8_t tech; // Next technique to try, or zero to look for a single first.
+  uint8_t hardest;
+  uint8_t done;
+};
+void su_hinter_begin(struct su_hinter *hinter,const uint8_t *grid);
+uint8_t su_hinter_step(struct su_hinter *hinter);
+
+/* Fill in place every cell that singles alone can reach from (grid).
+ * Returns the count filled, or <0 if (grid) contradicts itself, and then (grid) is untouched.
+ */
+int8_t su_fill_singles(uint8_t *grid);
+
+/* Canonical form.
+ * Two grids have the same canonical form exactly when one can be turned into the other by
+ * relabeling digits, permuting bands, stacks, and the rows and columns within them, and transposing.
+ * Blanks (0) stay blank. Canonicalize a puzzle's clues, not its solution, to catch isomorphic puzzles.
+ **********************************************************************/
+
+void su_canon(uint8_t *dst,const uint8_t *src);
+void su_canon_field(uint8_t *dst,const uint16_t *field); // Provided cells of a game field (see game.h).
+uint64_t su_canon_hash(const uint8_t *canon);
+
+/* Set of canonical hashes, for rejecting duplicates in a batch. Native only.
+ * Zero-initialize; su_canon_index_add() returns >0 if added, 0 if already present, <0 if allocation failed.
+ */
+struct su_canon_index {
+  uint64_t *v;
+  uint32_t c,a;
+};
+void su_canon_index_cleanup(struct su_canon_index *index);
+int su_canon_index_add(struct su_canon_index *index,uint64_t hash);
+
+/* Puzzle bank.
+ * A flat blob of pre-generated puzzles, as produced by the puzzlecvt tool:
+ *   u16be[SU_TIER_COUNT] Count of puzzles in each tier.
+ *   Records, all of tier 0, then tier 1, and so on. SU_BANK_RECORD_SIZE bytes each:
+ *     u8[11] Clue bitmap, row-major, high bit first.
+ *     u8[19] Solution rows 0..7, each a 19-bit permutation rank (lexicographic), big-endian bit order.
+ *            Row 8 is whatever each column is missing.
+ * Fixed-size records, so picking one is O(1), and nothing needs solving on the way out.
+ **********************************************************************/
+
+#define SU_BANK_HEADER_SIZE (SU_TIER_COUNT*2)
+#define SU_BANK_RECORD_SIZE 30
+
+// Fields are in game field format (see game.h). We only look at the provided bit and true value.
+void su_bank_encode(uint8_t *dst,const uint16_t *field);
+void su_bank_decode(uint16_t *field,const uint8_t *src);
+
+uint16_t su_bank_count(const uint8_t *bank,uint32_t bankc,uint8_t tier);
+const uint8_t *su_bank_get(const uint8_t *bank,uint32_t bankc,uint8_t tier,uint16_t index); // null if out of range
+
+/* PRNG.
+ * Small, fast, and reproducible: Same seed, same sequence, on every platform.
+ **********************************************************************/
+
+struct su_rng {
+  uint32_t s[4];
+};
+
+void su_rng_seed(struct su_rng *rng,uint64_t seed);
+uint32_t su_rng_next(struct su_rng *rng);
+uint32_t su_rng_below(struct su_rng *rng,uint32_t n); // 0..n-1, unbiased
+
+/* Generator.
+ * Each context carries its own PRNG, so threads can generate in parallel, and a seed reproduces its puzzle.
+ **********************************************************************/
+
+#define SU_GENERATOR_FILL   0 /* making a solution grid */
+#define SU_GENERATOR_EXPOSE 1 /* one pass of subgroup logic per step */
+#define SU_GENERATOR_REDUCE 2 /* one uniqueness check per step, then rate */
+#define SU_GENERATOR_DONE   3
+
+struct su_generator {
+  uint16_t possible[81]; // 0x1ff for each cell, which values remain possible
+  uint8_t expose[81]; // 1 if a cell should be visible to the user
+  uint8_t value[81]; // The final value 1..9 for each cell, 0 if we're generating it.
+  su_count_fn count; // Solver backend for uniqueness checks.
+  struct su_rng rng;
+  uint8_t symmetric; // Set after init: Nonzero to keep clues rotationally symmetric about the center.
+  uint8_t phase; // SU_GENERATOR_*
+  uint8_t clues[81]; // Reduction: Exposed values, 0 for hidden.
+  uint8_t order[81]; // Reduction: Exposed cells in the order we'll try hiding them.
+  uint8_t orderc,orderp;
+  struct su_solver solver; // Reduction: (clues) loaded, when (count) is su_count.
+  struct su_rating rating; // Valid when DONE.
+  // Counters for the last su_generator_generate(), for benchmarking:
+  uint16_t fillc; // Attempts to fill the solution grid.
+  uint16_t repc; // Passes of the exposure loop.
+  uint16_t retryc; // Times we threw out a grid and started over.
+  #if SU_STATS
+    struct su_stats stats; // Reset by su_generator_begin().
+  #endif
+};
+
+/* (count) is su_count or su_dlx_count, null for the default.
+ */
+void su_generator_init(struct su_generator *g,uint64_t seed,su_count_fn count);
+
+/* Generate a puzzle into 81 cells of game field format (see game.h).
+ * (rating) is optional; we always rate the output, and return its tier.
+ */
+uint8_t su_generator_generate(struct su_generator *g,uint16_t *v,struct su_rating *rating);
+
+/* Same thing in small pieces, if you can't afford to block.
+ * Each step is one fill attempt, one exposure pass, or one uniqueness check. Rating comes with the last.
+ * su_generator_step() returns a rough progress estimate 0..100, and 100 only when the puzzle is ready.
+ * Then su_generator_finish() is the tail end of su_generator_generate().
+ */
+void su_generator_begin(struct su_generator *g);
+uint8_t su_generator_step(struct su_generator *g);
+uint8_t su_generator_finish(struct su_generator *g,uint16_t *v,struct su_rating *rating);
+
+/* What the last generation took. Zeros if !SU_STATS.
+ * su_generator_generate_stats() is su_generator_generate() and this, in one call.
+ */
+void su_generator_stats(struct su_stats *dst,const struct su_generator *g);
+uint8_t su_generator_generate_stats(struct su_generator *g,uint16_t *v,struct su_rating *rating,struct su_stats *stats);
+
+/* Everything from one 64-bit seed, with the default backend.
+ * Store the seed instead of the puzzle, and you can regenerate it anywhere.
+ */
+uint8_t sudoku_generate_seeded(uint16_t *v,uint64_t seed);
+
+#endif
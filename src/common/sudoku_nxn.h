@@ -0,0 +1,45 @@
+/* sudoku_nxn.h
+ * Solvers and generators for sizes other than the classic 9x9, all from the template in su_nxn.h.
+ * Each size has its own prefix and its own mask type, eg su16_count(), su6_generator_generate().
+ * The small sizes are everywhere. The large ones are native-only, they want more RAM than the Tiny has to spare.
+ * su9 is the same game as sudoku.h, through the template; it's there to check the template against the classic solver.
+ */
+
+#ifndef SUDOKU_NXN_H
+#define SUDOKU_NXN_H
+
+#include "sudoku.h"
+
+#define SU_NXN_NAME su4
+#define SU_NXN_BOXW 2
+#define SU_NXN_BOXH 2
+#define SU_NXN_MASK uint8_t
+#define SU_NXN_CELL uint8_t
+#include "su_nxn.h"
+
+#define SU_NXN_NAME su6
+#define SU_NXN_BOXW 3
+#define SU_NXN_BOXH 2
+#define SU_NXN_MASK uint8_t
+#define SU_NXN_CELL uint8_t
+#include "su_nxn.h"
+
+#if BC_PLATFORM!=BC_PLATFORM_tiny
+
+#define SU_NXN_NAME su9
+#define SU_NXN_BOXW 3
+#define SU_NXN_BOXH 3
+#define SU_NXN_MASK uint16_t
+#define SU_NXN_CELL uint8_t
+#include "su_nxn.h"
+
+#define SU_NXN_NAME su16
+#define SU_NXN_BOXW 4
+#define SU_NXN_BOXH 4
+#define SU_NXN_MASK uint32_t
+#define SU_NXN_CELL uint16_t
+#include "su_nxn.h"
+
+#endif
+
+#endif
@@ -0,0 +1,128 @@
+#include "game.h"
+#include "board.h"
+#include "sudoku.h"
+#include <string.h>
+
+/* Conflict tracking.
+ * A label is in error when one of its three units shows that digit more than once, which is three lookups in (countv).
+ * Changing one cell can only flip the error flag on itself and on peers showing its old or new digit.
+ */
+
+static void board_tally_cell(uint8_t p,int8_t d) {
+  uint16_t v=game.field[p];
+  uint8_t digit=v&FIELD_CELL_LABEL;
+  if (!digit) return;
+  const uint8_t *u=su_cell_unitv[p];
+  game.countv[u[0]][digit-1]+=d;
+  game.countv[u[1]][digit-1]+=d;
+  game.countv[u[2]][digit-1]+=d;
+  game.filledc+=d;
+  if (digit!=((v&FIELD_CELL_VALUE)>>4)) game.wrongc+=d;
+}
+
+static void board_refresh_error(uint8_t p) {
+  uint16_t *v=game.field+p;
+  uint8_t digit=(*v)&FIELD_CELL_LABEL;
+  const uint8_t *u=su_cell_unitv[p];
+  if (digit&&(
+    (game.countv[u[0]][digit-1]>1)||
+    (game.countv[u[1]][digit-1]>1)||
+    (game.countv[u[2]][digit-1]>1)
+  )) (*v)|=FIELD_CELL_ERROR;
+  else (*v)&=~FIELD_CELL_ERROR;
+}
+
+/* Rebuild the counters from scratch, after (field) is replaced wholesale.
+ */
+
+void board_tally() {
+  memset(game.countv,0,sizeof(game.countv));
+  game.filledc=0;
+  game.wrongc=0;
+  uint8_t p=0; for (;p<81;p++) board_tally_cell(p,1);
+  for (p=0;p<81;p++) board_refresh_error(p);
+}
+
+/* Pencil marks.
+ * 9 bits per cell, packed. Cell (p) straddles at most two bytes, starting at bit (p*9).
+ */
+
+uint16_t board_notes_get(uint8_t p) {
+  uint16_t bitp=p*9;
+  const uint8_t *v=game.notev+(bitp>>3);
+  return ((v[0]|(v[1]<<8))>>(bitp&7))&SU_ALL;
+}
+
+void board_notes_set(uint8_t p,uint16_t notes) {
+  uint16_t bitp=p*9;
+  uint8_t *v=game.notev+(bitp>>3);
+  uint16_t word=v[0]|(v[1]<<8);
+  word=(word&~(SU_ALL<<(bitp&7)))|((notes&SU_ALL)<<(bitp&7));
+  v[0]=word;
+  v[1]=word>>8;
+}
+
+/* Set label.
+ * board_put_label() keeps the counters and error flags current, and that's all.
+ */
+
+static void board_put_label(uint8_t p,uint8_t digit) {
+  uint8_t old=game.field[p]&FIELD_CELL_LABEL;
+  if (digit==old) return;
+  board_tally_cell(p,-1);
+  game.field[p]=(game.field[p]&~FIELD_CELL_LABEL)|digit;
+  board_tally_cell(p,1);
+  board_refresh_error(p);
+  const uint8_t *peer=su_peerv[p];
+  uint8_t i=20;
+  for (;i-->0;peer++) {
+    uint8_t label=game.field[*peer]&FIELD_CELL_LABEL;
+    if (label&&((label==old)||(label==digit))) board_refresh_error(*peer);
+  }
+}
+
+void board_set_label(uint8_t p,uint8_t digit) {
+  if (digit==(game.field[p]&FIELD_CELL_LABEL)) return;
+  board_put_label(p,digit);
+  if (!digit) return;
+  uint16_t prune=1<<(digit-1);
+  const uint8_t *peer=su_peerv[p];
+  uint8_t i=20;
+  for (;i-->0;peer++) {
+    uint16_t notes=board_notes_get(*peer);
+    if (notes&prune) board_notes_set(*peer,notes&~prune);
+  }
+}
+
+/* Replay.
+ * Check the whole journal first, on a copy, so a bad one changes nothing.
+ * Every move must start from the label the one before left, and never touch a provided cell.
+ * The moves' times add up to (journal.lastms) less (startms), or less if some delta saturated.
+ * Notes aren't journalled, and the moves already pruned them once, so they stay as they are.
+ */
+
+uint8_t board_replay() {
+  if (game.journal.dropc) return 0;
+  uint8_t labels[81];
+  uint8_t p=0; for (;p<81;p++) labels[p]=(game.field[p]&FIELD_CELL_PROVIDED)?(game.field[p]&FIELD_CELL_LABEL):0;
+  struct journal journal=game.journal;
+  struct journal_move move;
+  while (journal_redo(&move,&journal)) ;
+  uint32_t ms=0;
+  uint8_t saturated=0,i=0;
+  for (;journal_get(&move,&journal,i);i++) {
+    if ((move.cell>=81)||(game.field[move.cell]&FIELD_CELL_PROVIDED)) return 0;
+    if (i<game.journal.p) {
+      if (move.from!=labels[move.cell]) return 0;
+      labels[move.cell]=move.to;
+    }
+    ms+=move.deltams;
+    if (move.deltams>=JOURNAL_DELTA_LIMIT) saturated=1;
+  }
+  uint32_t span=game.journal.lastms-game.startms;
+  if ((ms>span)||(!saturated&&(ms!=span))) return 0;
+  board_tally();
+  for (p=0;p<81;p++) if (!(game.field[p]&FIELD_CELL_PROVIDED)) board_put_label(p,0);
+  for (i=0;journal_get(&move,&game.journal,i);i++) board_put_label(move.cell,move.to);
+  return 1;
+}
@@ -0,0 +1,31 @@
+/* board.h
+ * Bookkeeping on the labels and pencil marks in (game), apart from the rest of the game so it can be tested alone.
+ * No drawing, no sound, no saving; game.c wraps these with all that.
+ */
+
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <stdint.h>
+
+/* Rebuild (game.countv), (filledc), (wrongc), and every error flag from the labels, after (field) is replaced wholesale.
+ */
+void board_tally();
+
+/* Change one cell's label and keep the counters and error flags current.
+ * Placing a digit also erases it from the notes of every peer.
+ */
+void board_set_label(uint8_t p,uint8_t digit);
+
+/* Pencil marks for one cell, bit (d-1) for digit (d).
+ */
+uint16_t board_notes_get(uint8_t p);
+void board_notes_set(uint8_t p,uint16_t notes);
+
+/* Rebuild every label from the provided cells and (game.journal), up to its undo point, one move at a time.
+ * Notes are left alone. Returns zero, with nothing changed, if the journal has lost moves off its old end,
+ * or doesn't agree with itself or the game clock.
+ */
+uint8_t board_replay();
+
+#endif
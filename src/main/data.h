@@ -22,6 +22,10 @@ extern const uint32_t error_len;
 extern const int16_t cancel[];
 extern const uint32_t cancel_len;
 
+// Puzzle bank, see su_bank_* in sudoku.h.
+extern const uint8_t bank[];
+extern const uint32_t bank_len;
+
 // Images.
 extern struct render_image tiles;
 extern struct render_image splash;
@@ -3,6 +3,10 @@
 #include "render.h"
 #include "data.h"
 #include "bbd.h"
+#include "sudoku.h"
+#include "pool.h"
+#include "save.h"
+#include "board.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -11,17 +15,63 @@ extern struct bbd bbd;
 
 struct game game={0};
 
+#define GAME_HINT_BUDGET_US 6000 /* per frame, for the hint search */
+
+/* Change one cell's label. A new label also voids any hint, and wants saving.
+ */
+
+static void game_set_label(uint8_t p,uint8_t digit) {
+  if (digit==(game.field[p]&FIELD_CELL_LABEL)) return;
+  game.hintp=0xff;
+  game.hinting=0;
+  save_touch();
+  board_set_label(p,digit);
+}
+
 /* Reset.
  */
  
 void game_reset() {
+  uint8_t difficulty=game.difficulty;
   memset(&game,0,sizeof(struct game));
+  game.difficulty=difficulty;
+  if (!pool_take_bank(game.field,difficulty)) {
+    if (!pool_ready(difficulty)) {
+      game.state=GAME_STATE_WAIT;
+      return;
+    }
+    pool_take(game.field,difficulty);
+  }
+  game.tier=difficulty;
+  board_tally();
+  game.hintp=0xff;
   game.state=GAME_STATE_PLAY;
   game.selzone=SELZONE_FIELD;
   game.fselx=4;
   game.fsely=4;
-  sudoku_generate(game.field);
   game.startms=millis();
+  journal_reset(&game.journal,game.startms);
+  save_touch();
+}
+
+/* Restore.
+ * A journal that disagrees with the saved board can't be undone safely, so it starts over from the board as saved.
+ * One that has only lost old moves is fine as it is; it just can't be replayed.
+ */
+
+uint8_t game_restore() {
+  game.hintp=0xff;
+  game.hinting=0;
+  game.pvinput=0;
+  if (game.state!=GAME_STATE_PLAY) {
+    game.state=GAME_STATE_INIT;
+    return 0;
+  }
+  if (!board_replay()) {
+    board_tally();
+    if (!game.journal.dropc) journal_reset(&game.journal,game.journal.lastms);
+  }
+  return 1;
 }
 
 /* Get time since start, in [h,m,s]
@@ -66,6 +116,17 @@ static void game_draw_tile_colorkey(
   );
 }
  
+/* Pencil marks: A dot for each noted digit, placed like the digits on the palette, 1 top left through 9 bottom right.
+ * Tiles are too small for legible micro-digits, but position reads just as well.
+ */
+
+static void game_draw_notes(void *dst,int dststride,uint16_t notes) {
+  uint16_t *v=dst;
+  uint8_t d=0; for (;d<9;d++) {
+    if (notes&(1<<d)) v[((d/3)*2+1)*dststride+(d%3)*2+1]=0x0000;
+  }
+}
+ 
 static void game_draw_cell(
   void *dst,int dststride,
   uint8_t col,uint8_t row,
@@ -82,6 +143,8 @@ static void game_draw_cell(
     } else {
       bgtileid+=6;
     }
+  } else if (row*9+col==game.hintp) {
+    bgtileid+=6;
   } else if (cell&FIELD_CELL_ERROR) {
     bgtileid+=10;
   } else if (cell&FIELD_CELL_PROVIDED) {
@@ -93,6 +156,9 @@ static void game_draw_cell(
   
   if ((digit>=1)&&(digit<=9)) {
     game_draw_tile_colorkey(dst,dststride,0x80+digit);
+  } else {
+    uint16_t notes=board_notes_get(row*9+col);
+    if (notes) game_draw_notes(dst,dststride,notes);
   }
 }
 
@@ -151,10 +217,14 @@ void game_draw(struct render_image *dst) {
         if ((game.selzone==SELZONE_PALETTE)&&(col==game.pselx)&&(row==game.psely)) {
           if (game.renderseq&0x10) bgtileid+=2;
           else bgtileid+=4;
+        } else if (!row&&!col&&game.notemode) {
+          bgtileid+=8;
         }
         game_draw_tile_opaque(dstp,dst->stride,bgtileid);
         if (digit>=1) {
           game_draw_tile_colorkey(dstp,dst->stride,0x80+digit);
+        } else if ((digit==-2)&&ddigit) {
+          game_draw_notes(dstp,dst->stride,SU_ALL);
         }
       }
     }
@@ -172,13 +242,24 @@ void game_draw(struct render_image *dst) {
     );
   }
   
-  // Clock.
+  // Clock. When done, it alternates with the best time for this tier, in yellow.
   {
     uint8_t showcolon=1;
+    uint16_t color=0xffff;
     if (game.state==GAME_STATE_PLAY) showcolon=(game_get_time(game.time,game.startms)<500);
+    uint8_t time[3];
+    memcpy(time,game.time,3);
+    if ((game.state==GAME_STATE_DONE)&&(game.renderseq&0x40)) {
+      uint32_t best=save_get_best(game.tier);
+      if (best) {
+        time[0]=best/3600;
+        time[1]=(best/60)%60;
+        time[2]=best%60;
+        color=0xe0ff; // yellow, byte-swapped 565
+      }
+    }
     const uint8_t *src=digits4x7.v;
     uint16_t *dstp=((uint16_t*)dst->v)+dst->stride*1+66;
-    uint16_t color=0xffff;
     #define DIGIT(n) { \
       render_blit_16_1_replace_unchecked( \
         dstp,1,dst->stride-4, \
@@ -199,13 +280,13 @@ void game_draw(struct render_image *dst) {
       ); \
       dstp+=2; \
     }
-    DIGIT(game.time[0]%10)
+    DIGIT(time[0]%10)
     COLON
-    DIGIT(game.time[1]/10)
-    DIGIT(game.time[1]%10)
+    DIGIT(time[1]/10)
+    DIGIT(time[1]%10)
     COLON
-    DIGIT(game.time[2]/10)
-    DIGIT(game.time[2]%10)
+    DIGIT(time[2]/10)
+    DIGIT(time[2]%10)
     #undef DIGIT
     #undef COLON
   }
@@ -219,71 +300,17 @@ void game_draw(struct render_image *dst) {
 static void game_finish() {
   game_get_time(game.time,game.startms);
   game.state=GAME_STATE_DONE;
-}
-
-/* Check one cell for errors (ie an exposed neighbor shows the same value).
- */
- 
-static uint8_t game_is_error(uint8_t col,uint8_t row,uint8_t digit) {
-  uint8_t i=0; for (;i<9;i++) {
-    if (i!=col) {
-      uint16_t neighbor=game.field[row*9+i];
-      if ((neighbor&15)==digit) {
-        game.field[row*9+i]|=FIELD_CELL_ERROR;
-        return 1;
-      }
-    }
-    if (i!=row) {
-      uint16_t neighbor=game.field[i*9+col];
-      if ((neighbor&15)==digit) {
-        game.field[i*9+col]|=FIELD_CELL_ERROR;
-        return 1;
-      }
-    }
-  }
-  uint8_t cola=(col/3)*3,rowa=(row/3)*3;
-  uint8_t colz=cola+2,rowz=rowa+2;
-  uint8_t qrow=rowa; for (;qrow<=rowz;qrow++) {
-    uint8_t qcol=cola; for (;qcol<=colz;qcol++) {
-      if ((qrow==row)&&(qcol==col)) continue;
-      uint16_t neighbor=game.field[qrow*9+qcol];
-      if ((neighbor&15)==digit) {
-        game.field[qrow*9+qcol]|=FIELD_CELL_ERROR;
-        return 1;
-      }
-    }
-  }
-  return 0;
+  save_best(game.tier,(millis()-game.startms)/1000);
+  save_touch();
 }
 
 /* Examine.
- * Check for errors and completion.
+ * Check for completion: Every cell labelled, and every label right.
  * Called after a change.
  */
  
 static void game_examine() {
-  uint8_t complete=1;
-  uint16_t *p=game.field;
-  uint8_t row=0; for (;row<9;row++) {
-    uint8_t col=0; for (;col<9;col++,p++) {
-      uint8_t digit=(*p)&FIELD_CELL_LABEL;
-      if (!digit) {
-        complete=0;
-        (*p)&=~FIELD_CELL_ERROR;
-        continue;
-      }
-      if (digit!=(((*p)>>4)&15)) {
-        //fprintf(stderr,"INCORRECT at %d,%d shown=%d real=%d\n",col,row,digit,((*p)>>4)&15);
-        complete=0;
-      }
-      if (game_is_error(col,row,digit)) {
-        (*p)|=FIELD_CELL_ERROR;
-      } else {
-        (*p)&=~FIELD_CELL_ERROR;
-      }
-    }
-  }
-  if (complete) {
+  if ((game.filledc==81)&&!game.wrongc) {
     game_finish();
   }
 }
@@ -307,6 +334,16 @@ static void game_move_selection(int8_t dx,int8_t dy) {
   }
 }
 
+/* Set a label as the player's move, so it can be undone.
+ */
+
+static void game_place(uint8_t p,uint8_t digit) {
+  uint8_t from=game.field[p]&FIELD_CELL_LABEL;
+  if (digit==from) return;
+  game_set_label(p,digit);
+  journal_record(&game.journal,p,from,digit,millis());
+}
+
 /* Select whatever's highlighted.
  */
  
@@ -332,10 +369,25 @@ static void game_activate() {
             }
           } break;
         case SELZONE_PALETTE: {
+            uint8_t p=game.fsely*9+game.fselx;
+            if (!game.psely&&!game.pselx) { // Top left toggles note mode.
+              bbd_pcm(&bbd,move,move_len);
+              game.notemode=!game.notemode;
+              break;
+            }
             uint8_t v=(game.psely-1)*3+game.pselx+1;
             if (v>9) v=0;
-            uint16_t *dst=game.field+game.fsely*9+game.fselx;
-            (*dst)=((*dst)&~FIELD_CELL_LABEL)|v;
+            if (game.notemode) { // Notes only on blank cells. Palette stays open, to toggle several.
+              if (game.field[p]&FIELD_CELL_LABEL) {
+                bbd_pcm(&bbd,error,error_len);
+              } else {
+                bbd_pcm(&bbd,placeok,placeok_len);
+                board_notes_set(p,v?(board_notes_get(p)^(1<<(v-1))):0);
+                save_touch();
+              }
+              break;
+            }
+            game_place(p,v);
             game.selzone=SELZONE_FIELD;
             game_examine();
             if (game.field[game.fsely*9+game.fselx]&FIELD_CELL_ERROR) {
@@ -361,18 +413,135 @@ static void game_cancel() {
   }
 }
 
+/* Undo and redo.
+ * The cursor jumps to the cell that changed, so you can see what happened.
+ */
+
+static void game_apply_move(uint8_t p,uint8_t digit) {
+  game_set_label(p,digit);
+  game.selzone=SELZONE_FIELD;
+  game.fselx=p%9;
+  game.fsely=p/9;
+  game_examine();
+}
+
+static void game_undo() {
+  struct journal_move move;
+  if (!journal_undo(&move,&game.journal)) {
+    bbd_pcm(&bbd,error,error_len);
+    return;
+  }
+  bbd_pcm(&bbd,cancel,cancel_len);
+  game_apply_move(move.cell,move.from);
+}
+
+static void game_redo() {
+  struct journal_move move;
+  if (!journal_redo(&move,&game.journal)) {
+    bbd_pcm(&bbd,error,error_len);
+    return;
+  }
+  bbd_pcm(&bbd,placeok,placeok_len);
+  game_apply_move(move.cell,move.to);
+}
+
+/* Hints.
+ * We work from the labels as shown, not the true values: A hint must follow from what's on the board, right or wrong.
+ * First ask highlights the next cell logic can fill. Asking again while it's highlighted fills it in.
+ * The search runs a few technique passes per frame, so a hard board doesn't stall the display.
+ */
+
+static void game_get_labels(uint8_t *dst) {
+  uint8_t p=0; for (;p<81;p++) dst[p]=game.field[p]&FIELD_CELL_LABEL;
+}
+
+static void game_hint_continue() {
+  uint32_t start=micros();
+  while (!su_hinter_step(&game.hinter)) {
+    if (micros()-start>=GAME_HINT_BUDGET_US) return;
+  }
+  game.hinting=0;
+  const struct su_hint *hint=&game.hinter.hint;
+  if (hint->p==0xff) {
+    bbd_pcm(&bbd,error,error_len);
+  } else if (hint->p==game.hintp) {
+    bbd_pcm(&bbd,placeok,placeok_len);
+    game_place(hint->p,hint->digit);
+    game_examine();
+  } else {
+    bbd_pcm(&bbd,palette,palette_len);
+    game.hintp=hint->p;
+  }
+}
+
+static void game_hint() {
+  if (game.hinting) return;
+  uint8_t grid[81];
+  game_get_labels(grid);
+  su_hinter_begin(&game.hinter,grid);
+  game.hinting=1;
+  game_hint_continue();
+}
+
+static void game_fill_singles() {
+  uint8_t grid[81];
+  game_get_labels(grid);
+  if (su_fill_singles(grid)<=0) {
+    bbd_pcm(&bbd,error,error_len);
+    return;
+  }
+  bbd_pcm(&bbd,placeok,placeok_len);
+  uint8_t p=0; for (;p<81;p++) game_place(p,grid[p]);
+  game_examine();
+}
+
+/* Choose difficulty, from the splash.
+ */
+ 
+static void game_change_difficulty(int8_t d) {
+  int8_t difficulty=game.difficulty+d;
+  if ((difficulty<0)||(difficulty>=SU_TIER_COUNT)) return;
+  bbd_pcm(&bbd,move,move_len);
+  game.difficulty=difficulty;
+  save_touch();
+}
+
 /* Update game.
  */
  
 void game_update(uint8_t input) {
-  if (input!=game.pvinput) {
+  if (game.state==GAME_STATE_WAIT) {
+    if (pool_ready(game.difficulty)) game_reset();
+    else game.pvinput=input;
+    return;
+  }
+  if ((game.state==GAME_STATE_INIT)&&(input!=game.pvinput)) {
     switch (input&(BUTTON_LEFT|BUTTON_RIGHT)&~game.pvinput) {
-      case BUTTON_LEFT: game_move_selection(-1,0); break;
-      case BUTTON_RIGHT: game_move_selection(1,0); break;
+      case BUTTON_LEFT: game_change_difficulty(-1); break;
+      case BUTTON_RIGHT: game_change_difficulty(1); break;
     }
-    switch (input&(BUTTON_UP|BUTTON_DOWN)&~game.pvinput) {
-      case BUTTON_UP: game_move_selection(0,-1); break;
-      case BUTTON_DOWN: game_move_selection(0,1); break;
+  }
+  if (game.hinting) game_hint_continue();
+  if (input!=game.pvinput) {
+    if ((game.state==GAME_STATE_PLAY)&&(input&BUTTON_B)) {
+      // Chords: Hold B, then Left to undo or Right to redo, Up for a hint, or Down to fill every single.
+      switch (input&(BUTTON_LEFT|BUTTON_RIGHT)&~game.pvinput) {
+        case BUTTON_LEFT: game_undo(); break;
+        case BUTTON_RIGHT: game_redo(); break;
+      }
+      switch (input&(BUTTON_UP|BUTTON_DOWN)&~game.pvinput) {
+        case BUTTON_UP: game_hint(); break;
+        case BUTTON_DOWN: game_fill_singles(); break;
+      }
+    } else {
+      switch (input&(BUTTON_LEFT|BUTTON_RIGHT)&~game.pvinput) {
+        case BUTTON_LEFT: game_move_selection(-1,0); break;
+        case BUTTON_RIGHT: game_move_selection(1,0); break;
+      }
+      switch (input&(BUTTON_UP|BUTTON_DOWN)&~game.pvinput) {
+        case BUTTON_UP: game_move_selection(0,-1); break;
+        case BUTTON_DOWN: game_move_selection(0,1); break;
+      }
     }
     if (input&BUTTON_A) {
       game_activate();
@@ -7,6 +7,8 @@
 #define GAME_H
 
 #include <stdint.h>
+#include "journal.h"
+#include "sudoku.h"
 
 // 7*9==63, just small enough to fit on the Tiny.
 #define TILESIZE 7
@@ -20,9 +22,12 @@
 #define FIELD_CELL_PROVIDED  0x0200
 #define FIELD_CELL_ERROR     0x0400
 
+#define GAME_NOTES_SIZE 92 /* 81 cells * 9 bits, rounded up to bytes */
+
 #define GAME_STATE_INIT 0
 #define GAME_STATE_PLAY 1
 #define GAME_STATE_DONE 2
+#define GAME_STATE_WAIT 3 /* new game requested, pool is empty */
 
 struct render_image;
 
@@ -35,15 +40,31 @@ extern struct game {
   int8_t pselx,psely; // 0..2, selection in palette
   uint8_t renderseq; // counts render frames for animation. overflows frequently
   uint8_t pvinput;
+  uint8_t tier; // SU_TIER_* of the puzzle in play, always the (difficulty) it was started at
+  uint8_t difficulty; // SU_TIER_*, what the user asked for. Survives game_reset().
   uint16_t field[81]; // 0x000f=value(1..9), 0x0010=visible, 0x0020=provided, 0x0040=error
+  // Kept in step with the labels in (field), so checking a move doesn't mean rescanning the board:
+  uint8_t countv[27][9]; // How many of each digit is showing in each unit, indexed like su_unitv.
+  uint8_t filledc; // Cells with a label.
+  uint8_t wrongc; // ...of which the label isn't the true value.
+  struct journal journal; // Label changes, for undo and redo.
+  uint8_t notev[GAME_NOTES_SIZE]; // Pencil marks, 9 bits per cell, cell (p) at bit (p*9), little-endian.
+  uint8_t notemode; // Nonzero if the palette toggles notes instead of setting the label.
+  uint8_t hintp; // Cell highlighted by the last hint, or 0xff. Cleared by any label change.
+  uint8_t hinting; // Nonzero while (hinter) is working. It takes a few frames on the Tiny.
+  struct su_hinter hinter;
 } game;
 
 void game_reset();
 
+/* After (game) is restored wholesale, eg from a save: Rebuild what's derived from (field), and drop anything in flight.
+ * The labels are rebuilt by replaying the journal, which checks it against the save.
+ * Returns nonzero if there's a game to resume. Otherwise we go back to the splash.
+ */
+uint8_t game_restore();
+
 void game_draw(struct render_image *dst);
 
 void game_update(uint8_t input);
 
-void sudoku_generate(uint16_t *v);
-
 #endif
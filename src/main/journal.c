@@ -0,0 +1,69 @@
+#include "journal.h"
+
+/* Pack and unpack.
+ */
+
+static uint32_t journal_pack(uint8_t cell,uint8_t from,uint8_t to,uint32_t deltams) {
+  if (deltams>JOURNAL_DELTA_LIMIT) deltams=JOURNAL_DELTA_LIMIT;
+  return (cell&0x7f)|((from&0x0f)<<7)|((to&0x0f)<<11)|(deltams<<15);
+}
+
+static void journal_unpack(struct journal_move *move,uint32_t src) {
+  move->cell=src&0x7f;
+  move->from=(src>>7)&0x0f;
+  move->to=(src>>11)&0x0f;
+  move->deltams=src>>15;
+}
+
+/* Reset.
+ */
+
+void journal_reset(struct journal *journal,uint32_t nowms) {
+  journal->head=0;
+  journal->c=0;
+  journal->p=0;
+  journal->dropc=0;
+  journal->lastms=nowms;
+}
+
+/* Record.
+ */
+
+void journal_record(struct journal *journal,uint8_t cell,uint8_t from,uint8_t to,uint32_t nowms) {
+  journal->c=journal->p;
+  if (journal->c>=JOURNAL_SIZE) {
+    journal->head=(journal->head+1)%JOURNAL_SIZE;
+    journal->c--;
+    if (journal->dropc<0xff) journal->dropc++;
+  }
+  journal->v[(journal->head+journal->c)%JOURNAL_SIZE]=journal_pack(cell,from,to,nowms-journal->lastms);
+  journal->lastms=nowms;
+  journal->c++;
+  journal->p=journal->c;
+}
+
+/* Undo, redo.
+ */
+
+uint8_t journal_undo(struct journal_move *move,struct journal *journal) {
+  if (!journal->p) return 0;
+  journal->p--;
+  journal_unpack(move,journal->v[(journal->head+journal->p)%JOURNAL_SIZE]);
+  return 1;
+}
+
+uint8_t journal_redo(struct journal_move *move,struct journal *journal) {
+  if (journal->p>=journal->c) return 0;
+  journal_unpack(move,journal->v[(journal->head+journal->p)%JOURNAL_SIZE]);
+  journal->p++;
+  return 1;
+}
+
+/* Random access.
+ */
+
+uint8_t journal_get(struct journal_move *move,const struct journal *journal,uint8_t index) {
+  if (index>=journal->p) return 0;
+  journal_unpack(move,journal->v[(journal->head+index)%JOURNAL_SIZE]);
+  return 1;
+}
@@ -0,0 +1,51 @@
+/* journal.h
+ * Undo/redo log of label changes, in a fixed ring. No allocation.
+ * Each move packs into 4 bytes:
+ *   0x0000007f Cell 0..80.
+ *   0x00000780 Label before, 0..9.
+ *   0x00007800 Label after, 0..9.
+ *   0xffff8000 Milliseconds since the previous move (or game start), saturating.
+ * When the ring is full, recording drops the oldest move, which can then no longer be undone or replayed.
+ * Recording after an undo discards everything that could have been redone, like every undo you've ever used.
+ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+
+#define JOURNAL_SIZE 64 /* moves; 256 bytes */
+#define JOURNAL_DELTA_LIMIT 0x1ffff /* ms, about two minutes */
+
+struct journal {
+  uint32_t v[JOURNAL_SIZE];
+  uint8_t head; // Oldest move's position in (v).
+  uint8_t c; // Moves recorded, applied or not.
+  uint8_t p; // Moves applied, 0..c. Undo goes below, redo above.
+  uint8_t dropc; // Moves lost off the old end, saturating.
+  uint32_t lastms; // Time of the last move recorded.
+};
+
+struct journal_move {
+  uint8_t cell;
+  uint8_t from,to;
+  uint32_t deltams;
+};
+
+void journal_reset(struct journal *journal,uint32_t nowms);
+
+void journal_record(struct journal *journal,uint8_t cell,uint8_t from,uint8_t to,uint32_t nowms);
+
+/* Step the cursor back or forward one move, and describe the move in (move).
+ * To undo, set (move->cell) to (move->from). To redo, to (move->to).
+ * Zero if there's nothing to undo or redo.
+ */
+uint8_t journal_undo(struct journal_move *move,struct journal *journal);
+uint8_t journal_redo(struct journal_move *move,struct journal *journal);
+
+/* Move (index), 0 the oldest still recorded, through (journal->p)-1 the latest applied.
+ * Zero if out of range.
+ */
+uint8_t journal_get(struct journal_move *move,const struct journal *journal,uint8_t index);
+
+#endif
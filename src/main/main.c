@@ -2,7 +2,10 @@
 #include "bbd.h"
 #include "render.h"
 #include "game.h"
+#include "pool.h"
+#include "save.h"
 #include "data.h"
+#include "sudoku.h"
 #include <string.h>
 
 #if BC_PLATFORM==BC_PLATFORM_tiny
@@ -14,9 +17,15 @@
 /* Globals.
  ****************************************************/
 
+// How long to spend generating puzzles each frame, after the frame is out.
+#define GENERATE_BUDGET_IDLE_US  4000
+#define GENERATE_BUDGET_WAIT_US 12000 /* when the user is waiting for it */
+
 static uint16_t fb[96*64];
 struct bbd bbd={0};
 static uint8_t pvinput=0;
+static uint8_t generate_progress=0;
+static uint8_t waitseq=0;
 
 static struct render_image fbimg={
   .v=fb,
@@ -33,9 +42,44 @@ int16_t audio_next() {
   return bbd_update(&bbd);
 }
 
+/* Splash with a progress bar along the bottom, while the generator catches up.
+ * A bright spot sweeps the bar, so it looks alive even when progress stalls.
+ */
+ 
+static void draw_wait() {
+  render_blit(&fbimg,0,0,&splash,0,0,96,64,0);
+  uint16_t *dst=fb+96*62;
+  uint8_t w=(generate_progress*96)/100;
+  uint8_t spot=(waitseq++)%96;
+  uint8_t x=0; for (;x<96;x++,dst++) {
+    uint16_t color;
+    if ((x>=spot)&&(x<spot+8)) color=0xffff;
+    else if (x<w) color=0xe007; // green, in our byte-swapped 565
+    else color=0x0000;
+    dst[0]=dst[96]=color;
+  }
+}
+
+/* Splash with the difficulty picker in the lower right corner:
+ * One bar per tier, each taller than the last, lit up to the selected one.
+ */
+ 
+static void draw_splash() {
+  render_blit(&fbimg,0,0,&splash,0,0,96,64,0);
+  uint8_t tier=0; for (;tier<SU_TIER_COUNT;tier++) {
+    uint16_t color=(tier<=game.difficulty)?0xffff:0x0842; // dark gray
+    uint8_t h=(tier+1)*2;
+    uint16_t *dst=fb+96*(62-h)+78+tier*4;
+    uint8_t y=0; for (;y<h;y++,dst+=96) {
+      dst[0]=dst[1]=dst[2]=color;
+    }
+  }
+}
+
 static void redraw() {
   switch (game.state) {
-    case GAME_STATE_INIT: render_blit(&fbimg,0,0,&splash,0,0,96,64,0); break;
+    case GAME_STATE_INIT: draw_splash(); break;
+    case GAME_STATE_WAIT: draw_wait(); break;
     case GAME_STATE_PLAY: game_draw(&fbimg); break;
     case GAME_STATE_DONE: game_draw(&fbimg); break;
     default: game.state=GAME_STATE_INIT;
@@ -52,9 +96,13 @@ void loop() {
   
   redraw();
   platform_send_framebuffer(fb);
+  
+  generate_progress=pool_step((game.state==GAME_STATE_WAIT)?GENERATE_BUDGET_WAIT_US:GENERATE_BUDGET_IDLE_US,game.difficulty);
+  save_update();
 }
 
 void setup() {
   bbd_init(&bbd,22050);
   platform_init();
+  save_load(); // Straight back into the game in progress, if there is one.
 }
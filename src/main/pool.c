@@ -0,0 +1,142 @@
+#include "platform.h"
+#include "pool.h"
+#include "game.h"
+#include "sudoku.h"
+#include "data.h"
+#include <string.h>
+
+/* Puzzles are packed to spare the Tiny's RAM: One nibble per solution digit, one bit per clue.
+ */
+ 
+struct pool_puzzle {
+  uint8_t value[41];
+  uint8_t provided[11];
+  uint8_t tier;
+};
+
+static struct pool {
+  struct pool_puzzle v[POOL_SIZE]; // Oldest first.
+  uint8_t c;
+  uint8_t busy; // Nonzero if (g) has a puzzle in progress.
+  uint8_t progress;
+  uint32_t seq; // Mixed into seeds.
+  struct su_generator g;
+} pool={0};
+
+static struct pool_bank_tier {
+  uint16_t start; // Random, chosen on first use.
+  uint16_t usedc;
+} pool_bankv[SU_TIER_COUNT]={0};
+
+/* Pack and unpack.
+ */
+ 
+static void pool_pack(struct pool_puzzle *dst,const uint16_t *field,uint8_t tier) {
+  memset(dst,0,sizeof(struct pool_puzzle));
+  uint8_t i=0; for (;i<81;i++) {
+    uint8_t digit=(field[i]&FIELD_CELL_VALUE)>>4;
+    dst->value[i>>1]|=(i&1)?digit:(digit<<4);
+    if (field[i]&FIELD_CELL_PROVIDED) dst->provided[i>>3]|=0x80>>(i&7);
+  }
+  dst->tier=tier;
+}
+
+static void pool_unpack(uint16_t *field,const struct pool_puzzle *src) {
+  uint8_t i=0; for (;i<81;i++) {
+    uint8_t digit=(i&1)?(src->value[i>>1]&15):(src->value[i>>1]>>4);
+    if (src->provided[i>>3]&(0x80>>(i&7))) {
+      field[i]=FIELD_CELL_PROVIDED|FIELD_CELL_VISIBLE|(digit<<4)|digit;
+    } else {
+      field[i]=digit<<4;
+    }
+  }
+}
+
+/* Position of the oldest puzzle of (tier), or of any other tier if (other), or (pool.c) if none.
+ */
+
+static uint8_t pool_find(uint8_t tier,uint8_t other) {
+  uint8_t i=0; for (;i<pool.c;i++) {
+    if ((pool.v[i].tier==tier)!=other) return i;
+  }
+  return pool.c;
+}
+
+static void pool_remove(uint8_t p) {
+  pool.c--;
+  memmove(pool.v+p,pool.v+p+1,sizeof(struct pool_puzzle)*(pool.c-p));
+}
+
+/* Add a fresh puzzle.
+ * When the pool is full, only one of (tier) gets in, and it bumps the oldest of some other tier.
+ */
+
+static void pool_add(const uint16_t *field,uint8_t tier,uint8_t want) {
+  if (pool.c>=POOL_SIZE) {
+    if (tier!=want) return;
+    uint8_t p=pool_find(want,1);
+    if (p>=pool.c) return;
+    pool_remove(p);
+  }
+  pool_pack(pool.v+pool.c++,field,tier);
+}
+
+/* Step.
+ * Full and holding one of (tier), we're done. Otherwise keep generating, and discard what we can't use.
+ */
+
+static uint8_t pool_satisfied(uint8_t tier) {
+  return (pool.c>=POOL_SIZE)&&(pool_find(tier,0)<pool.c);
+}
+ 
+uint8_t pool_step(uint32_t budget_us,uint8_t tier) {
+  if (pool_satisfied(tier)) return 100;
+  uint32_t start=micros();
+  do {
+    if (!pool.busy) {
+      su_generator_init(&pool.g,((uint64_t)(pool.seq++)<<32)|start,0);
+      su_generator_begin(&pool.g);
+      pool.busy=1;
+    }
+    if ((pool.progress=su_generator_step(&pool.g))>=100) {
+      uint16_t field[81];
+      struct su_rating rating;
+      uint8_t ftier=su_generator_finish(&pool.g,field,&rating);
+      if (rating.solved) pool_add(field,ftier,tier); // Hints can't finish the rest, so we don't serve them.
+      pool.busy=0;
+      pool.progress=0;
+      if (pool_satisfied(tier)) return 100;
+    }
+  } while (micros()-start<budget_us);
+  return pool.progress;
+}
+
+/* Take puzzle.
+ */
+
+uint8_t pool_ready(uint8_t tier) {
+  return pool_find(tier,0)<pool.c;
+}
+ 
+void pool_take(uint16_t *field,uint8_t tier) {
+  while (!pool_ready(tier)) pool_step(0,tier);
+  uint8_t p=pool_find(tier,0);
+  pool_unpack(field,pool.v+p);
+  pool_remove(p);
+}
+
+/* Take from bank.
+ */
+ 
+uint8_t pool_take_bank(uint16_t *field,uint8_t tier) {
+  if (tier>=SU_TIER_COUNT) return 0;
+  uint16_t c=su_bank_count(bank,bank_len,tier);
+  struct pool_bank_tier *bt=pool_bankv+tier;
+  if (bt->usedc>=c) return 0;
+  if (!bt->usedc) bt->start=micros()%c;
+  const uint8_t *src=su_bank_get(bank,bank_len,tier,(bt->start+bt->usedc)%c);
+  if (!src) return 0;
+  su_bank_decode(field,src);
+  bt->usedc++;
+  return 1;
+}
@@ -0,0 +1,36 @@
+/* pool.h
+ * A few puzzles generated ahead of time, so starting a new game doesn't wait on the generator.
+ * Generation is time-sliced: Call pool_step() once per frame, and it works on the next puzzle for as long as you allow.
+ * Puzzles come out by tier, so the player always gets the difficulty they picked.
+ * Ahead of all that, there's a bank of rated puzzles in flash, which can be had by tier and without waiting.
+ */
+ 
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdint.h>
+
+#define POOL_SIZE 4
+
+/* Work on the pool for about (budget_us) microseconds, at least one generator step.
+ * The generator can't be asked for a tier, so we keep generating until the pool is full and holds at least one of (tier).
+ * Puzzles that stall our techniques are thrown out, like the puzzle bank does.
+ * Returns progress 0..100 of the puzzle in flight, which may yet turn out the wrong tier, or 100 if the pool is satisfied.
+ */
+uint8_t pool_step(uint32_t budget_us,uint8_t tier);
+
+// Nonzero if pool_take() can return immediately.
+uint8_t pool_ready(uint8_t tier);
+
+/* Copy the oldest ready puzzle of (tier) into (field), game field format.
+ * If there isn't one, generate until there is, on the spot.
+ */
+void pool_take(uint16_t *field,uint8_t tier);
+
+/* Copy a puzzle of (tier) from the embedded bank into (field), game field format.
+ * Each one is served at most once per session, starting from a random point.
+ * Returns zero, with (field) untouched, once that tier is used up. Then it's the generator's turn.
+ */
+uint8_t pool_take_bank(uint16_t *field,uint8_t tier);
+
+#endif
@@ -0,0 +1,155 @@
+#include "platform.h"
+#include "save.h"
+#include "game.h"
+#include "sudoku.h"
+#include <string.h>
+
+#define SAVE_PATH "sudoku.sav"
+
+/* Each slot is this header, then the raw struct game.
+ * A slot gets a sector of its own (or several), so writing one never touches the other.
+ */
+
+struct save_header {
+  uint8_t magic[4]; // "SuSv"
+  uint8_t version; // SAVE_VERSION
+  uint8_t reserved;
+  uint16_t gamesize; // sizeof(struct game), in case we forgot to bump the version.
+  uint32_t seq; // Higher is newer.
+  uint32_t savems; // millis() at writing. Timestamps in (game) are relative to it.
+  uint32_t bestv[SU_TIER_COUNT]; // s
+  uint32_t checksum; // FNV-1a over the header up to here, then the game. Must be last.
+};
+
+#define SAVE_SLOT_SIZE ((sizeof(struct save_header)+sizeof(struct game)+511)&~511)
+
+static struct save {
+  uint32_t bestv[SU_TIER_COUNT];
+  uint32_t seq; // Of the last slot read or written.
+  uint8_t dirty;
+  uint32_t firstms; // First change since the last write.
+  uint32_t lastms; // Latest change.
+  uint32_t writtenms; // Last write, or attempt.
+} save={0};
+
+/* Checksum.
+ */
+
+static uint32_t save_hash(uint32_t h,const void *src,uint16_t srcc) {
+  const uint8_t *v=src;
+  for (;srcc-->0;v++) {
+    h^=*v;
+    h*=0x01000193;
+  }
+  return h;
+}
+
+static uint32_t save_checksum(const struct save_header *hdr) {
+  uint32_t h=save_hash(0x811c9dc5,hdr,sizeof(struct save_header)-sizeof(uint32_t));
+  return save_hash(h,&game,sizeof(struct game));
+}
+
+static uint8_t save_header_valid(const struct save_header *hdr) {
+  if (memcmp(hdr->magic,"SuSv",4)) return 0;
+  if (hdr->version!=SAVE_VERSION) return 0;
+  if (hdr->gamesize!=sizeof(struct game)) return 0;
+  return 1;
+}
+
+/* Load.
+ * Read both headers, then try the newer slot's body, then the older.
+ * Bodies go straight into (game), to spare the Tiny another copy of it.
+ */
+
+uint8_t save_load() {
+  struct save_header hdrv[2];
+  uint8_t validv[2];
+  uint8_t slot=0; for (;slot<2;slot++) {
+    validv[slot]=(
+      (ma_file_read(hdrv+slot,sizeof(struct save_header),SAVE_PATH,slot*SAVE_SLOT_SIZE)==sizeof(struct save_header))&&
+      save_header_valid(hdrv+slot)
+    );
+  }
+  uint8_t first=(validv[1]&&(!validv[0]||(hdrv[1].seq>hdrv[0].seq)))?1:0;
+  const struct save_header *hdr=0;
+  uint8_t i=0; for (;i<2;i++) {
+    slot=first^i;
+    if (!validv[slot]) continue;
+    int32_t c=ma_file_read(&game,sizeof(struct game),SAVE_PATH,slot*SAVE_SLOT_SIZE+sizeof(struct save_header));
+    if ((c==sizeof(struct game))&&(save_checksum(hdrv+slot)==hdrv[slot].checksum)) {
+      hdr=hdrv+slot;
+      break;
+    }
+  }
+  if (!hdr) {
+    memset(&game,0,sizeof(struct game));
+    return 0;
+  }
+
+  save.seq=hdr->seq;
+  memcpy(save.bestv,hdr->bestv,sizeof(save.bestv));
+  // The clock stops while we're off: Shift saved timestamps as if no time had passed.
+  uint32_t shift=millis()-hdr->savems;
+  game.startms+=shift;
+  game.journal.lastms+=shift;
+  return game_restore();
+}
+
+/* Write.
+ * Body first, then the header that vouches for it.
+ */
+
+static void save_write() {
+  struct save_header hdr={
+    .magic={'S','u','S','v'},
+    .version=SAVE_VERSION,
+    .gamesize=sizeof(struct game),
+    .seq=save.seq+1,
+    .savems=millis(),
+  };
+  save.writtenms=hdr.savems;
+  memcpy(hdr.bestv,save.bestv,sizeof(hdr.bestv));
+  hdr.checksum=save_checksum(&hdr);
+  int32_t p=(hdr.seq&1)*SAVE_SLOT_SIZE;
+  if (ma_file_write(SAVE_PATH,&game,sizeof(struct game),p+sizeof(struct save_header))<0) return;
+  if (ma_file_write(SAVE_PATH,&hdr,sizeof(struct save_header),p)<0) return;
+  save.seq=hdr.seq;
+}
+
+/* Debounce.
+ * A failed write isn't retried until the next change, or the next clock write. Without an SD card, that's the best we can do anyway.
+ */
+
+void save_touch() {
+  uint32_t now=millis();
+  if (!save.dirty) {
+    save.dirty=1;
+    save.firstms=now;
+  }
+  save.lastms=now;
+}
+
+void save_update() {
+  uint32_t now=millis();
+  if (!save.dirty) {
+    if ((game.state!=GAME_STATE_PLAY)||(now-save.writtenms<SAVE_CLOCK_MS)) return;
+  } else if ((now-save.lastms<SAVE_DEBOUNCE_MS)&&(now-save.firstms<SAVE_DELAY_LIMIT_MS)) return;
+  save.dirty=0;
+  save_write();
+}
+
+/* Best times.
+ */
+
+uint32_t save_get_best(uint8_t tier) {
+  if (tier>=SU_TIER_COUNT) return 0;
+  return save.bestv[tier];
+}
+
+uint8_t save_best(uint8_t tier,uint32_t s) {
+  if (tier>=SU_TIER_COUNT) return 0;
+  if (save.bestv[tier]&&(save.bestv[tier]<=s)) return 0;
+  save.bestv[tier]=s;
+  save_touch();
+  return 1;
+}
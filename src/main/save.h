@@ -0,0 +1,40 @@
+/* save.h
+ * The game in progress and best times per tier, kept across power cycles with ma_file_read() and ma_file_write().
+ * The file holds two slots, each a whole copy with its own sequence number and checksum.
+ * We always overwrite the older slot, so losing power mid-write costs at most the latest change.
+ * Writing to SD takes a while, so changes wait until the player pauses (debounced), but never too long.
+ * There's no warning before power goes off, so the clock only stands as of the last write.
+ * During play we write now and then even without a change, to bound what the clock can lose.
+ */
+
+#ifndef SAVE_H
+#define SAVE_H
+
+#include <stdint.h>
+
+#define SAVE_VERSION 1 /* bump whenever struct game or struct save_header changes shape */
+#define SAVE_DEBOUNCE_MS 2000 /* write after this long without a change... */
+#define SAVE_DELAY_LIMIT_MS 15000 /* ...or this long after the first unsaved change, whichever is first */
+#define SAVE_CLOCK_MS 60000 /* during play, write at least this often, for the clock's sake */
+
+/* Restore (game) and the best times from the newest good slot. Call once at boot.
+ * Returns nonzero if a game in progress was restored, and then it's ready to play, no generator required.
+ * Otherwise (game) is on the splash, with the last difficulty chosen if there was a save at all.
+ */
+uint8_t save_load();
+
+/* Note that something worth saving has changed.
+ */
+void save_touch();
+
+/* Call once per frame. Writes if a change is due.
+ */
+void save_update();
+
+/* Best time in seconds for a tier, or zero if none yet.
+ * save_best() records a finish time, and returns nonzero if it's a new best.
+ */
+uint32_t save_get_best(uint8_t tier);
+uint8_t save_best(uint8_t tier,uint32_t s);
+
+#endif
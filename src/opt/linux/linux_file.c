@@ -0,0 +1,78 @@
+#include "linux_internal.h"
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+/* Resolve a path under $XDG_DATA_HOME/sudoku, or ~/.local/share/sudoku, and make the directories.
+ * Returns (dst) or null.
+ */
+
+static const char *linux_file_path(char *dst,int dsta,const char *path) {
+  const char *base=getenv("XDG_DATA_HOME");
+  int dstc;
+  if (base&&base[0]) {
+    dstc=snprintf(dst,dsta,"%s/sudoku/%s",base,path);
+  } else {
+    const char *home=getenv("HOME");
+    if (!home||!home[0]) return 0;
+    dstc=snprintf(dst,dsta,"%s/.local/share/sudoku/%s",home,path);
+  }
+  if ((dstc<1)||(dstc>=dsta)) return 0;
+  char *sep=dst+1;
+  while ((sep=strchr(sep,'/'))) {
+    *sep=0;
+    mkdir(dst,0755);
+    *sep++='/';
+  }
+  return dst;
+}
+
+/* Read file.
+ */
+
+int32_t ma_file_read(void *dst,int32_t dsta,const char *path,int32_t seek) {
+  char fullpath[1024];
+  if (!linux_file_path(fullpath,sizeof(fullpath),path)) return -1;
+  int fd=open(fullpath,O_RDONLY);
+  if (fd<0) return -1;
+  if (seek&&(lseek(fd,seek,SEEK_SET)!=seek)) {
+    close(fd);
+    return 0;
+  }
+  int32_t dstc=0;
+  while (dstc<dsta) {
+    int err=read(fd,(char*)dst+dstc,dsta-dstc);
+    if (err<=0) break;
+    dstc+=err;
+  }
+  close(fd);
+  return dstc;
+}
+
+/* Write file.
+ * Seeking past the end leaves a hole, which reads back as zeroes.
+ */
+
+int32_t ma_file_write(const char *path,const void *src,int32_t srcc,int32_t seek) {
+  if (srcc<0) return -1;
+  char fullpath[1024];
+  if (!linux_file_path(fullpath,sizeof(fullpath),path)) return -1;
+  int fd=open(fullpath,O_RDWR|O_CREAT,0666);
+  if (fd<0) return -1;
+  if (lseek(fd,seek,SEEK_SET)!=seek) {
+    close(fd);
+    return -1;
+  }
+  int32_t srcp=0;
+  while (srcp<srcc) {
+    int err=write(fd,(const char*)src+srcp,srcc-srcp);
+    if (err<=0) {
+      close(fd);
+      return -1;
+    }
+    srcp+=err;
+  }
+  close(fd);
+  return 0;
+}
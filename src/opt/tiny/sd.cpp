@@ -11,7 +11,7 @@ static uint8_t sdinit=0;
  
 static int8_t ma_sd_require() {
   if (!sdinit) {
-    if (SD.begin()<0) return -1;
+    if (!SD.begin()) return -1;
     sdinit=1;
   }
   return 0;
@@ -25,7 +25,7 @@ int32_t ma_file_read(void *dst,int32_t dsta,const char *path,int32_t seek) {
   if (ma_sd_require()<0) return -1;
   File file=SD.open(path);
   if (!file) return -1;
-  if (seek&&(file.seek(seek)!=seek)) {
+  if (seek&&!file.seek(seek)) { // File::seek() returns a bool, and fails past the end.
     file.close();
     return 0;
   }
@@ -43,9 +43,11 @@ int32_t ma_file_write(const char *path,const void *src,int32_t srcc,int32_t seek
   File file=SD.open(path,O_RDWR|O_CREAT);
   if (!file) return -1;
   
+  // File::seek() returns a bool, and can't go past the end. So go to the end, and zero-fill up to (seek).
   if (seek) {
-    int32_t p=file.seek(seek);
-    if (p<0) {
+    int32_t p=file.size();
+    if (p>seek) p=seek;
+    if (!file.seek(p)) {
       file.close();
       return -1;
     }
@@ -61,8 +63,8 @@ int32_t ma_file_write(const char *path,const void *src,int32_t srcc,int32_t seek
     }
   }
   
-  size_t err=file.write((const uint8_t*)src,(size_t)srcc);
+  size_t c=file.write((const uint8_t*)src,(size_t)srcc);
   file.close();
-  if (err<0) return -1;
+  if (c!=(size_t)srcc) return -1;
   return 0;
 }
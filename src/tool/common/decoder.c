@@ -276,15 +276,12 @@ int decode_json_next(void *kpp,struct decoder *decoder) {
   
   if (decoder->jsonctx=='{') {
     if (!kpp) return decoder->jsonctx=-1;
-    if (((char*)decoder->src)[decoder->srcp]=='}') {
-      decoder->srcp++;
-      return 0;
-    }
+    if (((char*)decoder->src)[decoder->srcp]=='}') return 0; // leave it for decode_json_object_end()
     const char *k=(char*)decoder->src+decoder->srcp;
     int kc=sr_string_measure(k,decoder_remaining(decoder),0);
     if (kc<2) return decoder->jsonctx=-1;
     decoder->srcp+=kc;
-    if (kc==2) { k+=1; kc-=2; } // drop quotes if not empty
+    if (kc>2) { k+=1; kc-=2; } // drop quotes if not empty
     *(const char**)kpp=k;
     if (decode_json_prepare(decoder)<0) return -1;
     if (((char*)decoder->src)[decoder->srcp++]!=':') return decoder->jsonctx=-1;
@@ -292,6 +289,7 @@ int decode_json_next(void *kpp,struct decoder *decoder) {
     
   } else if (decoder->jsonctx=='[') {
     if (kpp) return decoder->jsonctx=-1;
+    if (((char*)decoder->src)[decoder->srcp]==']') return 0; // leave it for decode_json_array_end()
     return 1;
     
   } else return decoder->jsonctx=-1;
@@ -273,7 +273,7 @@ int encode_json_object_start(struct encoder *encoder,const char *k,int kc) {
   if (encode_raw(encoder,"{",1)<0) return encoder->jsonctx=-1;
   int jsonctx=encoder->jsonctx;
   encoder->jsonctx='{';
-  return encoder->jsonctx;
+  return jsonctx;
 }
 
 int encode_json_array_start(struct encoder *encoder,const char *k,int kc) {
@@ -281,7 +281,7 @@ int encode_json_array_start(struct encoder *encoder,const char *k,int kc) {
   if (encode_raw(encoder,"[",1)<0) return encoder->jsonctx=-1;
   int jsonctx=encoder->jsonctx;
   encoder->jsonctx='[';
-  return encoder->jsonctx;
+  return jsonctx;
 }
 
 /* End JSON structure.
@@ -0,0 +1,244 @@
+/* puzzlecvt_main.c
+ * Converts a text list of puzzles into a bank for flash (see "Puzzle bank" in sudoku.h).
+ *
+ * Input is line-oriented. '#' starts a comment. Each non-empty line is one of:
+ *   CLUES [...]
+ *     81 characters, '1'..'9' for clues, '.' or '0' for blanks. Anything after is ignored, so sugen's text output is fine.
+ *     We solve and rate it ourselves. It must have exactly one solution.
+ *   generate SEED EASY MEDIUM HARD EXPERT
+ *     Run the generator from SEED, SEED+1, ... until each tier has the given count of puzzles from this line.
+ *     Output depends only on the seed and the generator, so this is reproducible, and much smaller than the puzzles it stands for.
+ * Puzzles equivalent to one already in the bank (same canonical form) are dropped.
+ * So are puzzles our techniques can't finish, since hints couldn't help with them either.
+ */
+
+#include "tool/common/tool_context.h"
+#include "common/sudoku.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define PUZZLECVT_TIER_LIMIT 0xffff /* per tier, header fields are u16 */
+#define PUZZLECVT_ATTEMPTS_PER_PUZZLE 1000 /* "generate" gives up after so many seeds per puzzle requested */
+
+struct puzzlecvt_context {
+  struct tool_context hdr;
+  struct puzzlecvt_tier {
+    uint8_t *v; // SU_BANK_RECORD_SIZE each
+    int c,a;
+  } tierv[SU_TIER_COUNT];
+  struct su_canon_index index;
+  int dropc;
+  int stalledc;
+  int lineno;
+};
+
+static void puzzlecvt_context_cleanup(struct puzzlecvt_context *ctx) {
+  uint8_t i=0; for (;i<SU_TIER_COUNT;i++) {
+    if (ctx->tierv[i].v) free(ctx->tierv[i].v);
+  }
+  su_canon_index_cleanup(&ctx->index);
+  tool_context_cleanup(&ctx->hdr);
+}
+
+/* Add one puzzle, in game field format.
+ * Returns >0 if added, 0 if a duplicate, <0 for real errors.
+ */
+
+static int puzzlecvt_add(struct puzzlecvt_context *ctx,const uint16_t *field,uint8_t tier) {
+  if (tier>=SU_TIER_COUNT) return -1;
+  struct puzzlecvt_tier *t=ctx->tierv+tier;
+  if (t->c>=PUZZLECVT_TIER_LIMIT) {
+    fprintf(stderr,"%s: Too many puzzles in tier %d, limit %d\n",ctx->hdr.srcpath,tier,PUZZLECVT_TIER_LIMIT);
+    return -1;
+  }
+
+  uint8_t canon[81];
+  su_canon_field(canon,field);
+  int err=su_canon_index_add(&ctx->index,su_canon_hash(canon));
+  if (err<0) return -1;
+  if (!err) {
+    ctx->dropc++;
+    return 0;
+  }
+
+  if (t->c>=t->a) {
+    int na=t->a?(t->a<<1):256;
+    void *nv=realloc(t->v,na*SU_BANK_RECORD_SIZE);
+    if (!nv) return -1;
+    t->v=nv;
+    t->a=na;
+  }
+  uint8_t *record=t->v+t->c*SU_BANK_RECORD_SIZE;
+  su_bank_encode(record,field);
+
+  // Cheap insurance: A record that doesn't decode exactly is a bug here, not something to ship.
+  uint16_t check[81];
+  su_bank_decode(check,record);
+  uint8_t p=0; for (;p<81;p++) {
+    if ((check[p]&0x03f0)!=(field[p]&0x03f0)) {
+      fprintf(stderr,"%s:%d: Bank record failed to round-trip at cell %d\n",ctx->hdr.srcpath,ctx->lineno,p);
+      return -1;
+    }
+  }
+
+  t->c++;
+  return 1;
+}
+
+/* "generate SEED EASY MEDIUM HARD EXPERT"
+ */
+
+static int puzzlecvt_generate(struct puzzlecvt_context *ctx,const char *src,int srcc) {
+  char tmp[256];
+  if (srcc>=sizeof(tmp)) {
+    fprintf(stderr,"%s:%d: Line too long\n",ctx->hdr.srcpath,ctx->lineno);
+    return -1;
+  }
+  memcpy(tmp,src,srcc);
+  tmp[srcc]=0;
+  unsigned long long seed;
+  int wantv[SU_TIER_COUNT],n=0;
+  if (sscanf(tmp,"generate %llu %d %d %d %d %n",&seed,wantv+0,wantv+1,wantv+2,wantv+3,&n)<5||(n!=srcc)) {
+    fprintf(stderr,"%s:%d: Expected 'generate SEED EASY MEDIUM HARD EXPERT'\n",ctx->hdr.srcpath,ctx->lineno);
+    return -1;
+  }
+  int remaining=0;
+  uint8_t i=0; for (;i<SU_TIER_COUNT;i++) {
+    if ((wantv[i]<0)||(wantv[i]>PUZZLECVT_TIER_LIMIT)) {
+      fprintf(stderr,"%s:%d: Invalid count %d for tier %d\n",ctx->hdr.srcpath,ctx->lineno,wantv[i],i);
+      return -1;
+    }
+    remaining+=wantv[i];
+  }
+
+  long long attempts=(long long)remaining*PUZZLECVT_ATTEMPTS_PER_PUZZLE;
+  struct su_generator g;
+  for (;remaining>0;seed++) {
+    if (attempts--<=0) {
+      fprintf(stderr,
+        "%s:%d: Gave up with %d/%d/%d/%d puzzles still wanted. Ask for fewer in the rare tiers.\n",
+        ctx->hdr.srcpath,ctx->lineno,wantv[0],wantv[1],wantv[2],wantv[3]
+      );
+      return -1;
+    }
+    uint16_t field[81];
+    struct su_rating rating;
+    su_generator_init(&g,seed,0);
+    uint8_t tier=su_generator_generate(&g,field,&rating);
+    if ((tier>=SU_TIER_COUNT)||!wantv[tier]) continue;
+    if (!rating.solved) {
+      ctx->stalledc++;
+      continue;
+    }
+    int err=puzzlecvt_add(ctx,field,tier);
+    if (err<0) return -1;
+    if (!err) continue;
+    wantv[tier]--;
+    remaining--;
+  }
+  return 0;
+}
+
+/* One explicit puzzle.
+ */
+
+static int puzzlecvt_puzzle(struct puzzlecvt_context *ctx,const char *src,int srcc) {
+  uint8_t clues[81],solution[81];
+  if ((srcc<81)||((srcc>81)&&(src[81]!=' ')&&(src[81]!='\t'))) {
+    fprintf(stderr,"%s:%d: Expected 81-character puzzle\n",ctx->hdr.srcpath,ctx->lineno);
+    return -1;
+  }
+  uint8_t p=0; for (;p<81;p++) {
+    if ((src[p]>='1')&&(src[p]<='9')) clues[p]=src[p]-'0';
+    else if ((src[p]=='.')||(src[p]=='0')) clues[p]=0;
+    else {
+      fprintf(stderr,"%s:%d: Unexpected character '%c' in puzzle\n",ctx->hdr.srcpath,ctx->lineno,src[p]);
+      return -1;
+    }
+  }
+  uint32_t solutionc=su_count(solution,clues,2);
+  if (solutionc!=1) {
+    fprintf(stderr,"%s:%d: Puzzle has %s solution\n",ctx->hdr.srcpath,ctx->lineno,solutionc?"more than one":"no");
+    return -1;
+  }
+  struct su_rating rating;
+  if (!su_rate(&rating,clues)) {
+    ctx->stalledc++;
+    return 0;
+  }
+  uint16_t field[81];
+  for (p=0;p<81;p++) {
+    if (clues[p]) field[p]=0x0300|(solution[p]<<4)|solution[p];
+    else field[p]=solution[p]<<4;
+  }
+  if (puzzlecvt_add(ctx,field,rating.tier)<0) return -1;
+  return 0;
+}
+
+/* Process input.
+ */
+
+static int puzzlecvt_process(struct puzzlecvt_context *ctx) {
+  const char *src=ctx->hdr.src;
+  int srcc=ctx->hdr.srcc,srcp=0;
+  ctx->lineno=0;
+  while (srcp<srcc) {
+    ctx->lineno++;
+    const char *line=src+srcp;
+    int linec=0;
+    while ((srcp<srcc)&&(src[srcp++]!=0x0a)) linec++;
+    int i=0; for (;i<linec;i++) if (line[i]=='#') linec=i;
+    while (linec&&((unsigned char)line[linec-1]<=0x20)) linec--;
+    while (linec&&((unsigned char)line[0]<=0x20)) { line++; linec--; }
+    if (!linec) continue;
+    if ((linec>=8)&&!memcmp(line,"generate",8)) {
+      if (puzzlecvt_generate(ctx,line,linec)<0) return -1;
+    } else {
+      if (puzzlecvt_puzzle(ctx,line,linec)<0) return -1;
+    }
+  }
+  return 0;
+}
+
+/* Assemble the bank.
+ */
+
+static int puzzlecvt_encode(struct puzzlecvt_context *ctx) {
+  int total=0;
+  uint8_t i=0; for (;i<SU_TIER_COUNT;i++) total+=ctx->tierv[i].c;
+  int dstc=SU_BANK_HEADER_SIZE+total*SU_BANK_RECORD_SIZE;
+  uint8_t *dst=malloc(dstc);
+  if (!dst) return -1;
+  uint8_t *p=dst+SU_BANK_HEADER_SIZE;
+  for (i=0;i<SU_TIER_COUNT;i++) {
+    const struct puzzlecvt_tier *t=ctx->tierv+i;
+    dst[i<<1]=t->c>>8;
+    dst[(i<<1)+1]=t->c;
+    memcpy(p,t->v,t->c*SU_BANK_RECORD_SIZE);
+    p+=t->c*SU_BANK_RECORD_SIZE;
+  }
+  int err=tool_context_encode_text(&ctx->hdr,dst,dstc,8);
+  free(dst);
+  if (err<0) return -1;
+  fprintf(stderr,
+    "%s: %d puzzles (%d/%d/%d/%d by tier), %d bytes, %d duplicates and %d stalled dropped.\n",
+    ctx->hdr.srcpath,total,ctx->tierv[0].c,ctx->tierv[1].c,ctx->tierv[2].c,ctx->tierv[3].c,dstc,ctx->dropc,ctx->stalledc
+  );
+  return 0;
+}
+
+/* Main.
+ */
+
+int main(int argc,char **argv) {
+  struct puzzlecvt_context ctx={0};
+  if (tool_context_configure(&ctx.hdr,argc,argv,0)<0) return 1;
+  if (tool_context_acquire_input(&ctx.hdr)<0) return 1;
+  if (puzzlecvt_process(&ctx)<0) return 1;
+  if (puzzlecvt_encode(&ctx)<0) return 1;
+  if (tool_context_flush_output(&ctx.hdr)<0) return 1;
+  puzzlecvt_context_cleanup(&ctx);
+  return 0;
+}
@@ -0,0 +1,451 @@
+/* subench_main.c
+ * Generator benchmark.
+ * Generates puzzles from a fixed run of seeds (--seed+i) with each solver backend, one thread, and reports:
+ *   Latency per puzzle: mean, p50, p99, max.
+ *   Fill attempts, exposure passes, and retries, from the generator's counters.
+ *   Clue count and tier distributions, and how many puzzles stalled the rater.
+ *   A digest of every puzzle generated, so you can tell whether a change altered the output or only the speed.
+ * Report is JSON, to stdout or -oPATH.
+ * With --baseline=PATH, compare against an earlier report and fail if mean, p50, or p99 got slower by more than --tolerance percent.
+ */
+
+#include "tool/common/tool_context.h"
+#include "tool/common/serial.h"
+#include "tool/common/fs.h"
+#include "common/sudoku.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <limits.h>
+
+#define SUBENCH_WARMUP 8 /* puzzles generated untimed before each backend's run */
+
+struct subench_backend {
+  const char *name;
+  su_count_fn count;
+  uint8_t solverstats; // Nonzero if its searches feed the solver's counters: propagations, guesses.
+};
+
+static const struct subench_backend subench_backendv[]={
+  {"bitboard",su_count,1},
+  {"dlx",su_dlx_count,0},
+};
+#define SUBENCH_BACKEND_COUNT (int)(sizeof(subench_backendv)/sizeof(struct subench_backend))
+
+/* Latency metrics, in the order they appear in reports and get checked against the baseline.
+ */
+#define SUBENCH_METRIC_MEAN 0
+#define SUBENCH_METRIC_P50  1
+#define SUBENCH_METRIC_P99  2
+#define SUBENCH_METRIC_MAX  3
+#define SUBENCH_METRIC_COUNT 4
+
+static const char *subench_metric_namev[SUBENCH_METRIC_COUNT]={
+  "mean_us","p50_us","p99_us","max_us",
+};
+
+struct subench_result {
+  const char *name;
+  uint8_t solverstats;
+  double metricv[SUBENCH_METRIC_COUNT];
+  double fill_mean,rep_mean;
+  int fill_max,rep_max,retryc;
+  int cluev[82]; // Puzzles by count of clues.
+  int tierv[SU_TIER_COUNT];
+  int stalledc; // Rated Expert because our techniques couldn't finish them.
+  uint32_t digest; // FNV-1a over every generated field.
+  struct su_stats stats; // Summed over all puzzles.
+};
+
+struct subench_context {
+  struct tool_context hdr;
+  int count;
+  int seed;
+  int backendp; // Index in subench_backendv, or <0 for all.
+  const char *baseline;
+  int tolerance; // percent
+  struct subench_result resultv[SUBENCH_BACKEND_COUNT];
+  int resultc;
+};
+
+/* Run one backend.
+ */
+
+static double subench_now_us() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec*1000000.0+ts.tv_nsec/1000.0;
+}
+
+static int subench_cmp_double(const void *a,const void *b) {
+  double da=*(const double*)a,db=*(const double*)b;
+  if (da<db) return -1;
+  if (da>db) return 1;
+  return 0;
+}
+
+static int subench_run_backend(struct subench_context *ctx,const struct subench_backend *backend) {
+  struct subench_result *result=ctx->resultv+ctx->resultc++;
+  memset(result,0,sizeof(struct subench_result));
+  result->name=backend->name;
+  result->solverstats=backend->solverstats;
+  result->digest=0x811c9dc5;
+
+  double *usv=malloc(sizeof(double)*ctx->count);
+  if (!usv) return -1;
+  struct su_generator g;
+  uint16_t field[81];
+  struct su_rating rating;
+  int i;
+
+  // Warm up. DLX builds its matrix on first use, and we don't want that or cold caches in the figures.
+  for (i=0;i<SUBENCH_WARMUP;i++) {
+    su_generator_init(&g,(uint32_t)ctx->seed-1-i,backend->count);
+    su_generator_generate(&g,field,&rating);
+  }
+
+  double total=0.0;
+  long fillc=0,repc=0;
+  struct su_stats stats;
+  for (i=0;i<ctx->count;i++) {
+    su_generator_init(&g,(uint32_t)ctx->seed+i,backend->count);
+    double then=subench_now_us();
+    su_generator_generate_stats(&g,field,&rating,&stats);
+    usv[i]=subench_now_us()-then;
+    total+=usv[i];
+
+    result->stats.propagations+=stats.propagations;
+    result->stats.guesses+=stats.guesses;
+    result->stats.backtracks+=stats.backtracks;
+    result->stats.eliminations+=stats.eliminations;
+    result->stats.trials+=stats.trials;
+    result->stats.searches+=stats.searches;
+    result->stats.fill_ns+=stats.fill_ns;
+    result->stats.expose_ns+=stats.expose_ns;
+    result->stats.reduce_ns+=stats.reduce_ns;
+    result->stats.rate_ns+=stats.rate_ns;
+
+    fillc+=g.fillc;
+    repc+=g.repc;
+    if (g.fillc>result->fill_max) result->fill_max=g.fillc;
+    if (g.repc>result->rep_max) result->rep_max=g.repc;
+    result->retryc+=g.retryc;
+    result->tierv[rating.tier]++;
+    if (!rating.solved) result->stalledc++;
+    int cluec=0,p=0;
+    for (;p<81;p++) {
+      if (field[p]&0x0200) cluec++;
+      result->digest=(result->digest^(field[p]&0xff))*0x01000193;
+      result->digest=(result->digest^(field[p]>>8))*0x01000193;
+    }
+    result->cluev[cluec]++;
+  }
+
+  qsort(usv,ctx->count,sizeof(double),subench_cmp_double);
+  result->metricv[SUBENCH_METRIC_MEAN]=total/ctx->count;
+  result->metricv[SUBENCH_METRIC_P50]=usv[(ctx->count-1)*50/100];
+  result->metricv[SUBENCH_METRIC_P99]=usv[(ctx->count-1)*99/100];
+  result->metricv[SUBENCH_METRIC_MAX]=usv[ctx->count-1];
+  result->fill_mean=(double)fillc/ctx->count;
+  result->rep_mean=(double)repc/ctx->count;
+  free(usv);
+
+  fprintf(stderr,
+    "%s: mean %.0f us, p50 %.0f us, p99 %.0f us, max %.0f us\n",
+    result->name,
+    result->metricv[SUBENCH_METRIC_MEAN],result->metricv[SUBENCH_METRIC_P50],
+    result->metricv[SUBENCH_METRIC_P99],result->metricv[SUBENCH_METRIC_MAX]
+  );
+  return 0;
+}
+
+/* Encode report.
+ */
+
+/* Per-puzzle means of the generator's counters, if it was built with them.
+ * Only the bitboard backend counts propagations and guesses, so the others leave them out rather than report zeros.
+ * Backtracks come from the fill as well, so every backend has those, but only the bitboard's include search.
+ */
+
+static void subench_encode_stats(struct encoder *dst,const struct subench_result *result,int count) {
+  if (!SU_STATS) return;
+  const struct su_stats *stats=&result->stats;
+  int statsctx=encode_json_object_start(dst,"stats",5);
+  if (result->solverstats) {
+    encode_json_float(dst,"propagations",12,(double)stats->propagations/count);
+    encode_json_float(dst,"guesses",7,(double)stats->guesses/count);
+  }
+  encode_json_float(dst,"backtracks",10,(double)stats->backtracks/count);
+  encode_json_float(dst,"eliminations",12,(double)stats->eliminations/count);
+  encode_json_float(dst,"trials",6,(double)stats->trials/count);
+  encode_json_float(dst,"searches",8,(double)stats->searches/count);
+  encode_json_float(dst,"fill_us",7,stats->fill_ns/1000.0/count);
+  encode_json_float(dst,"expose_us",9,stats->expose_ns/1000.0/count);
+  encode_json_float(dst,"reduce_us",9,stats->reduce_ns/1000.0/count);
+  encode_json_float(dst,"rate_us",7,stats->rate_ns/1000.0/count);
+  encode_json_object_end(dst,statsctx);
+}
+
+static int subench_encode_result(struct encoder *dst,const struct subench_result *result,int count) {
+  int jsonctx=encode_json_object_start(dst,0,0);
+  encode_json_string(dst,"name",4,result->name,-1);
+  int i=0; for (;i<SUBENCH_METRIC_COUNT;i++) {
+    encode_json_float(dst,subench_metric_namev[i],-1,result->metricv[i]);
+  }
+  encode_json_float(dst,"fill_mean",9,result->fill_mean);
+  encode_json_int(dst,"fill_max",8,result->fill_max);
+  encode_json_float(dst,"repetitions_mean",16,result->rep_mean);
+  encode_json_int(dst,"repetitions_max",15,result->rep_max);
+  encode_json_int(dst,"retries",7,result->retryc);
+
+  int cluectx=encode_json_object_start(dst,"clues",5);
+  for (i=0;i<82;i++) {
+    if (!result->cluev[i]) continue;
+    char k[4];
+    int kc=sr_decsint_repr(k,sizeof(k),i);
+    encode_json_int(dst,k,kc,result->cluev[i]);
+  }
+  encode_json_object_end(dst,cluectx);
+
+  int tierctx=encode_json_array_start(dst,"tiers",5);
+  for (i=0;i<SU_TIER_COUNT;i++) encode_json_int(dst,0,0,result->tierv[i]);
+  encode_json_array_end(dst,tierctx);
+  encode_json_int(dst,"stalled",7,result->stalledc);
+
+  char digest[8];
+  int j=0; for (;j<8;j++) digest[j]=sr_hexdigit_repr(result->digest>>(28-j*4));
+  encode_json_string(dst,"digest",6,digest,8);
+  subench_encode_stats(dst,result,count);
+
+  return encode_json_object_end(dst,jsonctx);
+}
+
+static int subench_encode(struct subench_context *ctx) {
+  struct encoder *dst=&ctx->hdr.dst;
+  int jsonctx=encode_json_object_start(dst,0,0);
+  encode_json_int(dst,"count",5,ctx->count);
+  encode_json_int(dst,"seed",4,ctx->seed);
+  int arrayctx=encode_json_array_start(dst,"backends",8);
+  int i=0; for (;i<ctx->resultc;i++) {
+    if (subench_encode_result(dst,ctx->resultv+i,ctx->count)<0) return -1;
+  }
+  encode_json_array_end(dst,arrayctx);
+  if (encode_json_object_end(dst,jsonctx)<0) return -1;
+  if (encode_json_done(dst)<0) return -1;
+  return encode_raw(dst,"\n",1);
+}
+
+/* Compare one backend's figures against the baseline.
+ * Returns the count of regressions, or <0 after logging why the entry couldn't be read.
+ */
+
+static int subench_check_backend(struct subench_context *ctx,struct decoder *decoder) {
+  const struct subench_result *result=0;
+  double basev[SUBENCH_METRIC_COUNT]={0};
+  int jsonctx=decode_json_object_start(decoder);
+  const char *k;
+  int kc;
+  while ((kc=decode_json_next(&k,decoder))>0) {
+    if ((kc==4)&&!memcmp(k,"name",4)) {
+      char name[32];
+      int namec=decode_json_string(name,sizeof(name),decoder);
+      if ((namec<0)||(namec>=(int)sizeof(name))) {
+        fprintf(stderr,"%s: Invalid or overlong backend name.\n",ctx->baseline);
+        return -1;
+      }
+      int i=0; for (;i<ctx->resultc;i++) {
+        if ((int)strlen(ctx->resultv[i].name)!=namec) continue;
+        if (memcmp(ctx->resultv[i].name,name,namec)) continue;
+        result=ctx->resultv+i;
+        break;
+      }
+      continue;
+    }
+    int i=0; for (;i<SUBENCH_METRIC_COUNT;i++) {
+      if ((int)strlen(subench_metric_namev[i])!=kc) continue;
+      if (memcmp(subench_metric_namev[i],k,kc)) continue;
+      if (decode_json_float(basev+i,decoder)<0) {
+        fprintf(stderr,"%s: Expected number for '%s'.\n",ctx->baseline,subench_metric_namev[i]);
+        return -1;
+      }
+      break;
+    }
+    if (i>=SUBENCH_METRIC_COUNT) {
+      if (decode_json_skip(decoder)<0) {
+        fprintf(stderr,"%s: Malformed value for '%.*s'.\n",ctx->baseline,kc,k);
+        return -1;
+      }
+    }
+  }
+  if (decode_json_object_end(decoder,jsonctx)<0) {
+    fprintf(stderr,"%s: Malformed backend entry.\n",ctx->baseline);
+    return -1;
+  }
+  if (!result) return 0; // Not a backend we ran this time.
+
+  int regressionc=0,i=0;
+  for (;i<SUBENCH_METRIC_COUNT;i++) {
+    if (basev[i]<=0.0) continue;
+    double limit=basev[i]*(100+ctx->tolerance)/100.0;
+    double now=result->metricv[i];
+    int bad=(i!=SUBENCH_METRIC_MAX)&&(now>limit); // Max is one sample, too noisy to gate on.
+    fprintf(stderr,
+      "%s %s: %.0f us, baseline %.0f us (%+.1f%%)%s\n",
+      result->name,subench_metric_namev[i],now,basev[i],(now-basev[i])*100.0/basev[i],
+      bad?" REGRESSION":""
+    );
+    if (bad) regressionc++;
+  }
+  return regressionc;
+}
+
+/* Check the whole baseline. It must be from the same workload: (count) and (seed) both match ours.
+ * Our reports put those ahead of "backends", so we know before comparing any figures.
+ */
+
+static int subench_check_baseline(struct subench_context *ctx) {
+  char *src=0;
+  int srcc=file_read(&src,ctx->baseline);
+  if (srcc<0) {
+    fprintf(stderr,"%s: Failed to read baseline.\n",ctx->baseline);
+    return -1;
+  }
+  struct decoder decoder={.src=src,.srcc=srcc};
+  int regressionc=0,count=-1,seed=-1,seedok=0;
+  int jsonctx=decode_json_object_start(&decoder);
+  const char *k;
+  int kc;
+  while ((kc=decode_json_next(&k,&decoder))>0) {
+    if ((kc==5)&&!memcmp(k,"count",5)) {
+      if (decode_json_int(&count,&decoder)<0) count=-1;
+    } else if ((kc==4)&&!memcmp(k,"seed",4)) {
+      seedok=(decode_json_int(&seed,&decoder)>=0);
+    } else if ((kc==8)&&!memcmp(k,"backends",8)) {
+      if ((count!=ctx->count)||!seedok||(seed!=ctx->seed)) {
+        fprintf(stderr,
+          "%s: Baseline is for a different workload (count %d, seed %d; this run is count %d, seed %d). Not comparing.\n",
+          ctx->baseline,count,seedok?seed:-1,ctx->count,ctx->seed
+        );
+        free(src);
+        return -1;
+      }
+      int arrayctx=decode_json_array_start(&decoder);
+      while (decode_json_next(0,&decoder)>0) {
+        int err=subench_check_backend(ctx,&decoder);
+        if (err<0) {
+          free(src);
+          return -1;
+        }
+        regressionc+=err;
+      }
+      decode_json_array_end(&decoder,arrayctx);
+    } else {
+      decode_json_skip(&decoder);
+    }
+  }
+  decode_json_object_end(&decoder,jsonctx);
+  int err=decode_json_done(&decoder);
+  free(src);
+  if (err<0) {
+    fprintf(stderr,"%s: Malformed baseline.\n",ctx->baseline);
+    return -1;
+  }
+  if (regressionc) {
+    fprintf(stderr,"%s: %d figures slower than baseline by more than %d%%.\n",ctx->baseline,regressionc,ctx->tolerance);
+    return -1;
+  }
+  return 0;
+}
+
+/* Extra command-line options.
+ */
+
+static int cb_option(struct tool_context *astool,const char *k,int kc,const char *v,int vc) {
+  struct subench_context *ctx=(struct subench_context*)astool;
+
+  if ((kc==4)&&!memcmp(k,"help",4)) {
+    fprintf(stderr,
+      "Usage: subench [-oREPORT] [--count=1000] [--seed=1] [--backend=all|bitboard|dlx] [--baseline=REPORT] [--tolerance=20]\n"
+      "Writes the report to stdout if REPORT is unset.\n"
+      "With --baseline, fails if mean, p50, or p99 latency is more than TOLERANCE percent over the baseline's.\n"
+    );
+    return -1;
+  }
+
+  #define INTOPT(name,fld,lo,hi) if ((kc==sizeof(name)-1)&&!memcmp(k,name,kc)) { \
+    int n; \
+    if ((sr_int_eval(&n,v,vc)<2)||(n<lo)||(n>hi)) { \
+      fprintf(stderr,"subench: Expected integer in %d..%d for '%s', found '%.*s'\n",lo,hi,name,vc,v); \
+      return -1; \
+    } \
+    ctx->fld=n; \
+    return 1; \
+  }
+  INTOPT("count",count,1,INT_MAX)
+  INTOPT("seed",seed,0,INT_MAX)
+  INTOPT("tolerance",tolerance,0,INT_MAX)
+  #undef INTOPT
+
+  if ((kc==7)&&!memcmp(k,"backend",7)) {
+    if ((vc==3)&&!memcmp(v,"all",3)) {
+      ctx->backendp=-1;
+      return 1;
+    }
+    int i=0; for (;i<SUBENCH_BACKEND_COUNT;i++) {
+      if ((int)strlen(subench_backendv[i].name)!=vc) continue;
+      if (memcmp(subench_backendv[i].name,v,vc)) continue;
+      ctx->backendp=i;
+      return 1;
+    }
+    fprintf(stderr,"subench: Unknown backend '%.*s'\n",vc,v);
+    return -1;
+  }
+
+  if ((kc==8)&&!memcmp(k,"baseline",8)) {
+    ctx->baseline=v;
+    return 1;
+  }
+
+  return 0;
+}
+
+/* Main.
+ */
+
+int main(int argc,char **argv) {
+  struct subench_context ctx={
+    .count=1000,
+    .seed=1,
+    .backendp=-1,
+    .tolerance=20,
+  };
+  struct tool_context *astool=(struct tool_context*)&ctx;
+  if (tool_context_configure(astool,argc,argv,cb_option)<0) return 1;
+  if (astool->srcpath) {
+    fprintf(stderr,"%s: Unexpected input path '%s'\n",argv[0],astool->srcpath);
+    return 1;
+  }
+
+  int i=0; for (;i<SUBENCH_BACKEND_COUNT;i++) {
+    if ((ctx.backendp>=0)&&(ctx.backendp!=i)) continue;
+    if (subench_run_backend(&ctx,subench_backendv+i)<0) {
+      fprintf(stderr,"%s: Out of memory.\n",argv[0]);
+      return 1;
+    }
+  }
+
+  if (subench_encode(&ctx)<0) {
+    fprintf(stderr,"%s: Failed to encode report.\n",argv[0]);
+    return 1;
+  }
+  if (astool->dstpath) {
+    if (tool_context_flush_output(astool)<0) return 1;
+  } else {
+    fwrite(astool->dst.v,1,astool->dst.c,stdout);
+  }
+
+  if (ctx.baseline&&(subench_check_baseline(&ctx)<0)) return 1;
+  return 0;
+}
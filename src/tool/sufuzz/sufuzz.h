@@ -0,0 +1,35 @@
+/* sufuzz.h
+ * One fuzz case: Arbitrary bytes in, every generator and solver cross-checked against each other.
+ * The puzzle's canonical form must survive a random relabeling, permutation, and transpose of it.
+ * It also runs the game's board bookkeeping and undo journal (src/main/board.c, journal.c) through random moves.
+ * sufuzz_case.c and sufuzz_game.c have the checks, and nothing else, so they can also be built into a libFuzzer binary (see `make fuzz`).
+ *
+ * Input layout. Missing bytes read as zero, and extra bytes are ignored:
+ *   u64le  Generator seed.
+ *   u8     Flags: 0x01 symmetric.
+ *   ...    Edits to the generated puzzle, two bytes each: Cell (%81), then digit (%10, 0 to blank it).
+ *          Edits may well leave it with no solution or many; the solvers just have to agree about that.
+ */
+
+#ifndef SUFUZZ_H
+#define SUFUZZ_H
+
+#include <stdint.h>
+
+#define SUFUZZ_HEADER_SIZE 9
+#define SUFUZZ_EDIT_LIMIT 32 /* edits past this are ignored */
+#define SUFUZZ_STEP_LIMIT 100000 /* su_generator_step() calls per puzzle before we call it hung */
+#define SUFUZZ_COUNT_LIMIT 3 /* how far the solvers count an edited puzzle */
+#define SUFUZZ_GAME_MOVES 100 /* label changes per case, more than JOURNAL_SIZE so the ring wraps */
+
+/* Run one case. Returns 0 if everything agreed.
+ * Otherwise <0, with a description of the first disagreement in (msg).
+ */
+int sufuzz_case(char *msg,int msga,const uint8_t *src,int srcc);
+
+/* Conflict counters, error flags, notes, undo/redo, and replay, over moves on (field), a generated puzzle in game format.
+ * The same edits as sufuzz_case() uses lead, then more from (seed). In sufuzz_game.c.
+ */
+int sufuzz_check_game(char *msg,int msga,const uint16_t *field,uint64_t seed,const uint8_t *src,int srcc);
+
+#endif
@@ -0,0 +1,318 @@
+#include "sufuzz.h"
+#include "common/sudoku.h"
+#include "common/sudoku_nxn.h"
+#include <stdio.h>
+#include <string.h>
+
+#define FAIL(...) { snprintf(msg,msga,__VA_ARGS__); return -1; }
+
+/* Every backend shaped like su_count, all expected to agree.
+ */
+
+static uint32_t sufuzz_count_variant(uint8_t *solution,const uint8_t *clues,uint32_t limit) {
+  static const struct su_variant classic={0};
+  return su_variant_count(solution,&classic,clues,limit);
+}
+
+static const struct sufuzz_backend {
+  const char *name;
+  su_count_fn count;
+} sufuzz_backendv[]={
+  {"bitboard",su_count},
+  {"dlx",su_dlx_count},
+  {"su9",su9_count},
+  {"variant",sufuzz_count_variant},
+};
+#define SUFUZZ_BACKEND_COUNT (sizeof(sufuzz_backendv)/sizeof(struct sufuzz_backend))
+
+/* Grid checks.
+ */
+
+static int sufuzz_grid_valid(const uint8_t *grid) {
+  uint8_t u=0; for (;u<27;u++) {
+    uint16_t seen=0;
+    uint8_t i=0; for (;i<9;i++) {
+      uint8_t digit=grid[su_unitv[u][i]];
+      if ((digit<1)||(digit>9)) return 0;
+      seen|=1<<(digit-1);
+    }
+    if (seen!=SU_ALL) return 0;
+  }
+  return 1;
+}
+
+static int sufuzz_grid_fits(const uint8_t *grid,const uint8_t *clues) {
+  uint8_t p=0; for (;p<81;p++) {
+    if (clues[p]&&(clues[p]!=grid[p])) return 0;
+  }
+  return 1;
+}
+
+/* Generate the same puzzle two ways: In steps with the bitboard backend, and in one call with DLX.
+ * Backends only answer "is it unique", so the output must be identical.
+ */
+
+static int sufuzz_generate(char *msg,int msga,uint16_t *field,struct su_rating *rating,uint64_t seed,uint8_t symmetric) {
+  struct su_generator g;
+  su_generator_init(&g,seed,su_count);
+  g.symmetric=symmetric;
+  su_generator_begin(&g);
+  int stepc=0;
+  while (su_generator_step(&g)<100) {
+    if (++stepc>=SUFUZZ_STEP_LIMIT) FAIL("Generator still going after %d steps",stepc)
+  }
+  su_generator_finish(&g,field,rating);
+  struct su_stats stats;
+  su_generator_stats(&stats,&g);
+  if (stats.contradictions) FAIL("Exposure hit %d contradictions",stats.contradictions)
+
+  uint16_t other[81];
+  struct su_rating otherrating;
+  su_generator_init(&g,seed,su_dlx_count);
+  g.symmetric=symmetric;
+  su_generator_generate(&g,other,&otherrating);
+  if (memcmp(field,other,sizeof(other))) FAIL("Stepwise bitboard and one-shot DLX generated different puzzles")
+  if (
+    (rating->score!=otherrating.score)||(rating->tier!=otherrating.tier)||
+    (rating->techniques!=otherrating.techniques)||(rating->solved!=otherrating.solved)
+  ) FAIL("Same puzzle, different ratings")
+  return 0;
+}
+
+/* The generated puzzle must be a valid grid, exactly one solution from every backend, and rate the same again.
+ */
+
+static int sufuzz_check_puzzle(char *msg,int msga,uint8_t *clues,const uint16_t *field,const struct su_rating *rating,uint8_t symmetric) {
+  uint8_t value[81];
+  uint8_t p=0; for (;p<81;p++) {
+    value[p]=(field[p]>>4)&15;
+    if (field[p]&0x0200) {
+      if ((field[p]&0x030f)!=(0x0300|value[p])) FAIL("Cell %d: Provided but not visible, or label differs from value",p)
+      clues[p]=value[p];
+    } else {
+      if (field[p]&0x030f) FAIL("Cell %d: Not provided, but visible or labelled",p)
+      clues[p]=0;
+    }
+  }
+  if (!sufuzz_grid_valid(value)) FAIL("Generated solution is not a valid grid")
+  if (symmetric) {
+    for (p=0;p<41;p++) if (!clues[p]!=!clues[80-p]) FAIL("Cells %d and %d break symmetry",p,80-p)
+  }
+
+  uint8_t i=0; for (;i<SUFUZZ_BACKEND_COUNT;i++) {
+    uint8_t solution[81];
+    uint32_t count=sufuzz_backendv[i].count(solution,clues,SUFUZZ_COUNT_LIMIT);
+    if (count!=1) FAIL("Generated puzzle has %d solutions per %s",count,sufuzz_backendv[i].name)
+    if (memcmp(solution,value,81)) FAIL("%s solved the generated puzzle differently",sufuzz_backendv[i].name)
+  }
+
+  struct su_rating again;
+  su_rate(&again,clues);
+  if ((again.score!=rating->score)||(again.tier!=rating->tier)) FAIL("Rating the puzzle again gave a different answer")
+
+  // Hints and filled singles come from logic alone, so they must agree with the only solution.
+  struct su_hint hint;
+  if (su_hint(&hint,clues)) {
+    if ((hint.p>=81)||clues[hint.p]) FAIL("Hint at cell %d, which isn't blank",hint.p)
+    if (hint.digit!=value[hint.p]) FAIL("Hint says %d at cell %d, solution has %d",hint.digit,hint.p,value[hint.p])
+  } else if (rating->solved) {
+    FAIL("No hint, but the rater solved it")
+  }
+  uint8_t filled[81];
+  memcpy(filled,clues,81);
+  if (su_fill_singles(filled)<0) FAIL("Filling singles found a contradiction")
+  if (!sufuzz_grid_fits(value,filled)) FAIL("Filling singles contradicts the solution")
+  return 0;
+}
+
+/* Edit the puzzle and compare backends again.
+ * Counts must match. Solutions may differ when there are several, but each must be valid and fit the clues.
+ */
+
+static int sufuzz_check_edits(char *msg,int msga,uint8_t *clues,const uint8_t *src,int srcc) {
+  int editc=srcc>>1;
+  if (editc>SUFUZZ_EDIT_LIMIT) editc=SUFUZZ_EDIT_LIMIT;
+  for (;editc-->0;src+=2) clues[src[0]%81]=src[1]%10;
+
+  uint32_t expect=0;
+  uint8_t expectv[81];
+  uint8_t i=0; for (;i<SUFUZZ_BACKEND_COUNT;i++) {
+    uint8_t solution[81];
+    uint32_t count=sufuzz_backendv[i].count(solution,clues,SUFUZZ_COUNT_LIMIT);
+    if (count) {
+      if (!sufuzz_grid_valid(solution)) FAIL("%s returned an invalid grid",sufuzz_backendv[i].name)
+      if (!sufuzz_grid_fits(solution,clues)) FAIL("%s returned a grid that contradicts the clues",sufuzz_backendv[i].name)
+    }
+    if (!i) {
+      expect=count;
+      memcpy(expectv,solution,81);
+    } else if (count!=expect) {
+      FAIL("Edited puzzle: %s found %d solutions, %s found %d",sufuzz_backendv[0].name,expect,sufuzz_backendv[i].name,count)
+    } else if ((count==1)&&memcmp(solution,expectv,81)) {
+      FAIL("Edited puzzle: %s and %s disagree on the only solution",sufuzz_backendv[0].name,sufuzz_backendv[i].name)
+    }
+  }
+
+  // The rater has no answer to check, but it must cope with anything.
+  struct su_rating rating;
+  su_rate(&rating,clues);
+  struct su_hint hint;
+  if (su_hint(&hint,clues)&&((hint.p>=81)||clues[hint.p]||(hint.digit<1)||(hint.digit>9))) FAIL("Hint at cell %d, digit %d",hint.p,hint.digit)
+  return 0;
+}
+
+/* A random element of the symmetry group su_canon() works under:
+ * Relabel digits, shuffle bands, stacks, and the rows and columns within them, then maybe transpose.
+ */
+
+struct sufuzz_symmetry {
+  uint8_t map[10];
+  uint8_t rowv[9],colv[9]; // Source row and column for each output row and column.
+  uint8_t transpose;
+};
+
+static void sufuzz_shuffle(uint8_t *v,uint8_t c,struct su_rng *rng) {
+  while (c>1) {
+    uint8_t p=su_rng_below(rng,c--);
+    uint8_t tmp=v[p]; v[p]=v[c]; v[c]=tmp;
+  }
+}
+
+static void sufuzz_shuffle_lines(uint8_t *v,struct su_rng *rng) {
+  uint8_t blockv[3]={0,1,2};
+  sufuzz_shuffle(blockv,3,rng);
+  uint8_t i=0; for (;i<3;i++) {
+    uint8_t linev[3]={0,1,2};
+    sufuzz_shuffle(linev,3,rng);
+    uint8_t j=0; for (;j<3;j++) v[i*3+j]=blockv[i]*3+linev[j];
+  }
+}
+
+static void sufuzz_symmetry_init(struct sufuzz_symmetry *sym,struct su_rng *rng) {
+  uint8_t i=0; for (;i<10;i++) sym->map[i]=i;
+  sufuzz_shuffle(sym->map+1,9,rng);
+  sufuzz_shuffle_lines(sym->rowv,rng);
+  sufuzz_shuffle_lines(sym->colv,rng);
+  sym->transpose=su_rng_below(rng,2);
+}
+
+static void sufuzz_symmetry_apply(uint8_t *dst,const struct sufuzz_symmetry *sym,const uint8_t *src) {
+  uint8_t p=0; for (;p<81;p++) {
+    uint8_t r=p/9,c=p%9;
+    if (sym->transpose) { uint8_t tmp=r; r=c; c=tmp; }
+    dst[p]=sym->map[src[sym->rowv[r]*9+sym->colv[c]]];
+  }
+}
+
+/* Canonical form must not change under the symmetries, and must be its own canonical form.
+ * Also what `sugen --unique` does: Hash the provided cells of each field, and the index only takes the first of equivalents.
+ * A full grid is the slow case for su_canon(), so only some cases try the solution too.
+ */
+
+static int sufuzz_check_canon(char *msg,int msga,const uint16_t *field,uint64_t seed) {
+  struct su_rng rng;
+  su_rng_seed(&rng,seed^0xca11);
+  struct sufuzz_symmetry sym;
+  sufuzz_symmetry_init(&sym,&rng);
+  uint8_t clues[81],value[81],movedclues[81],movedvalue[81];
+  uint8_t p=0; for (;p<81;p++) {
+    value[p]=(field[p]>>4)&15;
+    clues[p]=(field[p]&0x0200)?value[p]:0;
+  }
+  sufuzz_symmetry_apply(movedclues,&sym,clues);
+  sufuzz_symmetry_apply(movedvalue,&sym,value);
+
+  uint8_t canon[81],other[81];
+  su_canon(canon,clues);
+  su_canon(other,movedclues);
+  if (memcmp(canon,other,81)) FAIL("Canonical form of the puzzle changed under relabeling, permutation, or transpose")
+  su_canon(other,canon);
+  if (memcmp(canon,other,81)) FAIL("Canonical form of the puzzle isn't its own canonical form")
+  if (!(seed&3)) {
+    su_canon(canon,value);
+    su_canon(other,movedvalue);
+    if (memcmp(canon,other,81)) FAIL("Canonical form of the solution changed under relabeling, permutation, or transpose")
+  }
+
+  uint16_t moved[81];
+  for (p=0;p<81;p++) {
+    moved[p]=movedvalue[p]<<4;
+    if (movedclues[p]) moved[p]|=0x0300|movedvalue[p];
+  }
+  su_canon_field(canon,field);
+  su_canon_field(other,moved);
+  struct su_canon_index index={0};
+  int added=su_canon_index_add(&index,su_canon_hash(canon));
+  int again=su_canon_index_add(&index,su_canon_hash(other));
+  su_canon_index_cleanup(&index);
+  if ((added!=1)||(again!=0)) FAIL("Canonical index took an equivalent puzzle as new (%d then %d)",added,again)
+  return 0;
+}
+
+/* The small template sizes, from the same seed.
+ */
+
+static int sufuzz_check_nxn(char *msg,int msga,uint64_t seed,uint8_t symmetric) {
+  #define SIZE(n,name) { \
+    struct name##_generator g; \
+    uint8_t clues[n*n],solution[n*n],check[n*n]; \
+    name##_generator_init(&g,seed); \
+    g.symmetric=symmetric; \
+    name##_generator_generate(&g,clues,solution); \
+    uint32_t count=name##_count(check,clues,SUFUZZ_COUNT_LIMIT); \
+    if (count!=1) FAIL("%s puzzle has %d solutions",#name,count) \
+    if (memcmp(check,solution,n*n)) FAIL("%s solved its own puzzle differently",#name) \
+  }
+  SIZE(4,su4)
+  SIZE(6,su6)
+  #undef SIZE
+  return 0;
+}
+
+/* Run one case.
+ */
+
+int sufuzz_case(char *msg,int msga,const uint8_t *src,int srcc) {
+  uint8_t header[SUFUZZ_HEADER_SIZE]={0};
+  if (srcc>=SUFUZZ_HEADER_SIZE) {
+    memcpy(header,src,SUFUZZ_HEADER_SIZE);
+    src+=SUFUZZ_HEADER_SIZE;
+    srcc-=SUFUZZ_HEADER_SIZE;
+  } else if (srcc>0) {
+    memcpy(header,src,srcc);
+    srcc=0;
+  } else {
+    srcc=0;
+  }
+  uint64_t seed=0;
+  uint8_t i=8; while (i-->0) seed=(seed<<8)|header[i];
+  uint8_t symmetric=header[8]&0x01;
+
+  uint16_t field[81];
+  uint8_t clues[81];
+  struct su_rating rating;
+  if (sufuzz_generate(msg,msga,field,&rating,seed,symmetric)<0) return -1;
+  if (sufuzz_check_puzzle(msg,msga,clues,field,&rating,symmetric)<0) return -1;
+  if (sufuzz_check_canon(msg,msga,field,seed)<0) return -1;
+  if (sufuzz_check_edits(msg,msga,clues,src,srcc)<0) return -1;
+  if (sufuzz_check_game(msg,msga,field,seed,src,srcc)<0) return -1;
+  if (sufuzz_check_nxn(msg,msga,seed,symmetric)<0) return -1;
+  return 0;
+}
+
+/* libFuzzer entry point, only in the `make fuzz` build.
+ */
+
+#ifdef SUFUZZ_LIBFUZZER
+#include <stdlib.h>
+#include <limits.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t *src,size_t srcc) {
+  char msg[256];
+  if (sufuzz_case(msg,sizeof(msg),src,(srcc>INT_MAX)?INT_MAX:(int)srcc)<0) {
+    fprintf(stderr,"sufuzz: %s\n",msg);
+    abort();
+  }
+  return 0;
+}
+#endif
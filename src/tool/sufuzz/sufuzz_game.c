@@ -0,0 +1,206 @@
+#include "sufuzz.h"
+#include "common/sudoku.h"
+#include "main/game.h"
+#include "main/board.h"
+#include "main/journal.h"
+#include <stdio.h>
+#include <string.h>
+
+#define FAIL(...) { snprintf(msg,msga,__VA_ARGS__); return -1; }
+
+// board.c works on the one global game. The game proper isn't in this build, so it's ours.
+struct game game;
+
+/* What we expect, tracked the slow and obvious way.
+ */
+
+static struct sufuzz_shadow {
+  uint16_t notev[81];
+  uint8_t historyv[SUFUZZ_GAME_MOVES+1][81]; // Labels after each journalled move.
+  struct journal_move movev[SUFUZZ_GAME_MOVES];
+  int movec;
+} shadow;
+
+static void sufuzz_get_labels(uint8_t *dst) {
+  uint8_t p=0; for (;p<81;p++) dst[p]=game.field[p]&FIELD_CELL_LABEL;
+}
+
+/* Counters, error flags, and notes must match a recount from scratch.
+ */
+
+static int sufuzz_check_board(char *msg,int msga,const char *when) {
+  uint8_t countv[27][9]={0};
+  uint8_t filledc=0,wrongc=0,p=0,u,d;
+  for (;p<81;p++) {
+    uint8_t digit=game.field[p]&FIELD_CELL_LABEL;
+    if (!digit) continue;
+    for (u=0;u<3;u++) countv[su_cell_unitv[p][u]][digit-1]++;
+    filledc++;
+    if (digit!=((game.field[p]&FIELD_CELL_VALUE)>>4)) wrongc++;
+  }
+  for (u=0;u<27;u++) for (d=0;d<9;d++) {
+    if (countv[u][d]!=game.countv[u][d]) FAIL("%s: Unit %d shows %d of digit %d, counter says %d",when,u,countv[u][d],d+1,game.countv[u][d])
+  }
+  if (filledc!=game.filledc) FAIL("%s: %d cells filled, counter says %d",when,filledc,game.filledc)
+  if (wrongc!=game.wrongc) FAIL("%s: %d cells wrong, counter says %d",when,wrongc,game.wrongc)
+  for (p=0;p<81;p++) {
+    uint8_t digit=game.field[p]&FIELD_CELL_LABEL,error=0;
+    if (digit) for (u=0;u<3;u++) if (countv[su_cell_unitv[p][u]][digit-1]>1) error=1;
+    if (!error!=!(game.field[p]&FIELD_CELL_ERROR)) FAIL("%s: Cell %d error flag is %s",when,p,error?"clear":"set")
+    if (board_notes_get(p)!=shadow.notev[p]) FAIL("%s: Cell %d notes 0x%03x, expected 0x%03x",when,p,board_notes_get(p),shadow.notev[p])
+  }
+  return 0;
+}
+
+/* Replaying the journal must land exactly on the live game, or refuse and change nothing.
+ * When it can replay, a move claiming a provided cell must make it refuse.
+ */
+
+static struct game snapshot;
+
+static int sufuzz_check_replay(char *msg,int msga,const char *when) {
+  memcpy(&snapshot,&game,sizeof(struct game));
+  uint8_t expect=!game.journal.dropc;
+  if (board_replay()!=expect) FAIL("%s: board_replay() returned %d with %d moves dropped",when,!expect,game.journal.dropc)
+  if (memcmp(&snapshot,&game,sizeof(struct game))) FAIL("%s: Replay changed the game",when)
+  struct journal_move move;
+  if (expect&&journal_get(&move,&game.journal,0)) {
+    game.field[move.cell]|=FIELD_CELL_PROVIDED;
+    memcpy(&snapshot,&game,sizeof(struct game));
+    if (board_replay()) FAIL("%s: Replayed a move on provided cell %d",when,move.cell)
+    if (memcmp(&snapshot,&game,sizeof(struct game))) FAIL("%s: Failed replay changed the game",when)
+    game.field[move.cell]&=~FIELD_CELL_PROVIDED;
+  }
+  return 0;
+}
+
+/* Change a label, and prune peer notes in the shadow the way board_set_label() should.
+ */
+
+static void sufuzz_set_label(uint8_t p,uint8_t digit) {
+  if (digit==(game.field[p]&FIELD_CELL_LABEL)) return;
+  board_set_label(p,digit);
+  if (!digit) return;
+  uint8_t i=0; for (;i<20;i++) shadow.notev[su_peerv[p][i]]&=~(1<<(digit-1));
+}
+
+/* Undo everything the journal kept, then redo it all, checking the board at each step.
+ */
+
+static int sufuzz_check_undo(char *msg,int msga) {
+  int keptc=(shadow.movec>JOURNAL_SIZE)?JOURNAL_SIZE:shadow.movec;
+  int dropc=shadow.movec-keptc;
+  if (dropc>0xff) dropc=0xff;
+  if (game.journal.dropc!=dropc) FAIL("Journal dropped %d moves, expected %d",game.journal.dropc,dropc)
+
+  if (sufuzz_check_replay(msg,msga,"Wrapped")<0) return -1;
+
+  struct journal_move move;
+  int i=0; for (;i<keptc;i++) {
+    const struct journal_move *expect=shadow.movev+shadow.movec-keptc+i;
+    if (!journal_get(&move,&game.journal,i)) FAIL("journal_get(%d) failed with %d moves kept",i,keptc)
+    if ((move.cell!=expect->cell)||(move.from!=expect->from)||(move.to!=expect->to)||(move.deltams!=expect->deltams)) {
+      FAIL("journal_get(%d): cell %d %d->%d after %u ms, expected cell %d %d->%d after %u ms",
+        i,move.cell,move.from,move.to,move.deltams,expect->cell,expect->from,expect->to,expect->deltams)
+    }
+  }
+  if (journal_get(&move,&game.journal,keptc)) FAIL("journal_get(%d) succeeded with only %d moves kept",keptc,keptc)
+
+  uint8_t labels[81];
+  int k=shadow.movec;
+  while (journal_undo(&move,&game.journal)) {
+    if (k<=shadow.movec-keptc) FAIL("Undid more than the %d moves kept",keptc)
+    sufuzz_set_label(move.cell,move.from);
+    k--;
+    sufuzz_get_labels(labels);
+    if (memcmp(labels,shadow.historyv[k],81)) FAIL("Labels after undoing to move %d don't match",k)
+    if (sufuzz_check_board(msg,msga,"Undo")<0) return -1;
+  }
+  if (k!=shadow.movec-keptc) FAIL("Undo stopped at move %d, expected %d",k,shadow.movec-keptc)
+
+  while (journal_redo(&move,&game.journal)) {
+    if (k>=shadow.movec) FAIL("Redid past the last move")
+    sufuzz_set_label(move.cell,move.to);
+    k++;
+    sufuzz_get_labels(labels);
+    if (memcmp(labels,shadow.historyv[k],81)) FAIL("Labels after redoing to move %d don't match",k)
+    if (sufuzz_check_board(msg,msga,"Redo")<0) return -1;
+  }
+  if (k!=shadow.movec) FAIL("Redo stopped at move %d of %d",k,shadow.movec)
+
+  // Recording after an undo discards the redo.
+  if (keptc&&journal_undo(&move,&game.journal)) {
+    sufuzz_set_label(move.cell,move.from);
+    uint8_t to=move.from?0:move.to;
+    journal_record(&game.journal,move.cell,move.from,to,0);
+    sufuzz_set_label(move.cell,to);
+    if (journal_redo(&move,&game.journal)) FAIL("Redo still available after recording a new move")
+  }
+  return 0;
+}
+
+/* Run random moves from the generated puzzle: The case's edits first, then more from the seed,
+ * until SUFUZZ_GAME_MOVES label changes are journalled, enough to wrap the ring. About a quarter change notes instead.
+ */
+
+int sufuzz_check_game(char *msg,int msga,const uint16_t *field,uint64_t seed,const uint8_t *src,int srcc) {
+  memset(&game,0,sizeof(struct game));
+  memset(&shadow,0,sizeof(shadow));
+  memcpy(game.field,field,sizeof(game.field));
+  board_tally();
+  if (sufuzz_check_board(msg,msga,"Initial tally")<0) return -1;
+  uint32_t nowms=0;
+  journal_reset(&game.journal,nowms);
+  sufuzz_get_labels(shadow.historyv[0]);
+
+  struct su_rng rng;
+  su_rng_seed(&rng,seed^0x5afe);
+  int editc=srcc>>1;
+  if (editc>SUFUZZ_EDIT_LIMIT) editc=SUFUZZ_EDIT_LIMIT;
+  int i=0; for (;shadow.movec<SUFUZZ_GAME_MOVES;i++) {
+    if (i>=SUFUZZ_GAME_MOVES*8) FAIL("Only %d moves journalled after %d tries",shadow.movec,i)
+    uint8_t p,digit,notes;
+    if (i<editc) {
+      p=src[i*2]%81;
+      digit=src[i*2+1]%10;
+      notes=!(src[i*2+1]&0xc0);
+    } else {
+      p=su_rng_below(&rng,81);
+      digit=su_rng_below(&rng,10);
+      notes=!su_rng_below(&rng,4);
+    }
+
+    if (notes) {
+      uint16_t v=su_rng_next(&rng)&SU_ALL;
+      board_notes_set(p,v);
+      shadow.notev[p]=v;
+      if (sufuzz_check_board(msg,msga,"Notes")<0) return -1;
+      continue;
+    }
+
+    if (game.field[p]&FIELD_CELL_PROVIDED) continue;
+    uint8_t from=game.field[p]&FIELD_CELL_LABEL;
+    if (from==digit) continue;
+    sufuzz_set_label(p,digit);
+    nowms+=su_rng_below(&rng,4)?su_rng_below(&rng,5000):su_rng_below(&rng,JOURNAL_DELTA_LIMIT*2);
+    uint32_t deltams=nowms-game.journal.lastms;
+    journal_record(&game.journal,p,from,digit,nowms);
+    struct journal_move *move=shadow.movev+shadow.movec++;
+    move->cell=p;
+    move->from=from;
+    move->to=digit;
+    move->deltams=(deltams>JOURNAL_DELTA_LIMIT)?JOURNAL_DELTA_LIMIT:deltams;
+    sufuzz_get_labels(shadow.historyv[shadow.movec]);
+    if (sufuzz_check_board(msg,msga,"Move")<0) return -1;
+    if (sufuzz_check_replay(msg,msga,"Move")<0) return -1;
+    if (shadow.movec==JOURNAL_SIZE/2) { // Replay stops at the undo point.
+      struct journal_move step;
+      int k=0; for (;(k<3)&&journal_undo(&step,&game.journal);k++) sufuzz_set_label(step.cell,step.from);
+      if (sufuzz_check_replay(msg,msga,"Partly undone")<0) return -1;
+      while ((k-->0)&&journal_redo(&step,&game.journal)) sufuzz_set_label(step.cell,step.to);
+      if (sufuzz_check_board(msg,msga,"Redo")<0) return -1;
+    }
+  }
+
+  return sufuzz_check_undo(msg,msga);
+}
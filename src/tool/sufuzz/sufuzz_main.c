@@ -0,0 +1,162 @@
+/* sufuzz_main.c
+ * Differential tester for the generator and solvers. See sufuzz.h for what one case checks.
+ *
+ * Three ways to run it:
+ *   sufuzz [--count=1000] [--seed=TIME]
+ *     Random cases, and a report of each failure with its input in hex. Exits nonzero if any failed.
+ *     This is what `make test` runs, with a fixed seed.
+ *   sufuzz --case=HEX
+ *     Replay one case, eg one reported by a random run.
+ *   sufuzz FILE
+ *     Run the file's bytes as one case, and abort() on failure. For AFL: `afl-fuzz -i in -o out -- out/tool/sufuzz @@`.
+ * libFuzzer uses sufuzz_case.c directly and doesn't need this file; see `make fuzz`.
+ */
+
+#include "tool/common/tool_context.h"
+#include "tool/common/serial.h"
+#include "common/sudoku.h"
+#include "sufuzz.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <limits.h>
+
+#define SUFUZZ_CASE_LIMIT (SUFUZZ_HEADER_SIZE+SUFUZZ_EDIT_LIMIT*2)
+
+struct sufuzz_context {
+  struct tool_context hdr;
+  int count;
+  uint64_t seed;
+  uint8_t casev[SUFUZZ_CASE_LIMIT]; // From --case.
+  int casec; // <0 if --case unset.
+};
+
+/* Run one case and report a failure.
+ */
+
+static int sufuzz_run(const uint8_t *src,int srcc,const char *name) {
+  char msg[256];
+  if (sufuzz_case(msg,sizeof(msg),src,srcc)>=0) return 0;
+  fprintf(stderr,"%s: %s\n  --case=",name,msg);
+  int i=0; for (;i<srcc;i++) fprintf(stderr,"%02x",src[i]);
+  fprintf(stderr,"\n");
+  return -1;
+}
+
+/* Random cases.
+ */
+
+static int sufuzz_run_random(struct sufuzz_context *ctx) {
+  struct su_rng rng;
+  su_rng_seed(&rng,ctx->seed);
+  int failc=0,i=0;
+  for (;i<ctx->count;i++) {
+    uint8_t src[SUFUZZ_CASE_LIMIT];
+    int srcc=su_rng_below(&rng,SUFUZZ_CASE_LIMIT+1);
+    int p=0; for (;p<srcc;p++) src[p]=su_rng_next(&rng);
+    char name[32];
+    snprintf(name,sizeof(name),"case %d",i);
+    if (sufuzz_run(src,srcc,name)<0) failc++;
+  }
+  fprintf(stderr,"sufuzz: %d cases from seed %llu, %d failed.\n",ctx->count,(unsigned long long)ctx->seed,failc);
+  return failc?-1:0;
+}
+
+/* Extra command-line options.
+ */
+
+static int sufuzz_hexdigit(char ch) {
+  if ((ch>='0')&&(ch<='9')) return ch-'0';
+  if ((ch>='a')&&(ch<='f')) return ch-'a'+10;
+  if ((ch>='A')&&(ch<='F')) return ch-'A'+10;
+  return -1;
+}
+
+static int cb_option(struct tool_context *astool,const char *k,int kc,const char *v,int vc) {
+  struct sufuzz_context *ctx=(struct sufuzz_context*)astool;
+
+  if ((kc==4)&&!memcmp(k,"help",4)) {
+    fprintf(stderr,
+      "Usage: sufuzz [--count=1000] [--seed=TIME]\n"
+      "   Or: sufuzz --case=HEX\n"
+      "   Or: sufuzz FILE\n"
+      "Cross-checks the generator and every solver backend. See src/tool/sufuzz/sufuzz.h for the input format.\n"
+    );
+    return -1;
+  }
+
+  if ((kc==5)&&!memcmp(k,"count",5)) {
+    int n;
+    if ((sr_int_eval(&n,v,vc)<2)||(n<1)) {
+      fprintf(stderr,"sufuzz: Expected positive integer for 'count', found '%.*s'\n",vc,v);
+      return -1;
+    }
+    ctx->count=n;
+    return 1;
+  }
+
+  if ((kc==4)&&!memcmp(k,"seed",4)) {
+    char tmp[32];
+    char *end=0;
+    if ((vc>0)&&(vc<sizeof(tmp))) {
+      memcpy(tmp,v,vc);
+      tmp[vc]=0;
+      ctx->seed=strtoull(tmp,&end,0);
+    }
+    if (!end||*end) {
+      fprintf(stderr,"sufuzz: Expected 64-bit integer for 'seed', found '%.*s'\n",vc,v);
+      return -1;
+    }
+    return 1;
+  }
+
+  if ((kc==4)&&!memcmp(k,"case",4)) {
+    if ((vc&1)||(vc>SUFUZZ_CASE_LIMIT*2)) {
+      fprintf(stderr,"sufuzz: Expected up to %d bytes of hex for 'case'\n",SUFUZZ_CASE_LIMIT);
+      return -1;
+    }
+    ctx->casec=0;
+    int i=0; for (;i<vc;i+=2) {
+      int hi=sufuzz_hexdigit(v[i]),lo=sufuzz_hexdigit(v[i+1]);
+      if ((hi<0)||(lo<0)) {
+        fprintf(stderr,"sufuzz: Invalid hex '%.*s'\n",vc,v);
+        return -1;
+      }
+      ctx->casev[ctx->casec++]=(hi<<4)|lo;
+    }
+    return 1;
+  }
+
+  return 0;
+}
+
+/* Main.
+ */
+
+int main(int argc,char **argv) {
+  struct sufuzz_context ctx={
+    .count=1000,
+    .seed=time(0),
+    .casec=-1,
+  };
+  struct tool_context *astool=(struct tool_context*)&ctx;
+  if (tool_context_configure(astool,argc,argv,cb_option)<0) return 1;
+
+  if (astool->srcpath) {
+    if (tool_context_acquire_input(astool)<0) return 1;
+    if (sufuzz_run(astool->src,astool->srcc,astool->srcpath)<0) abort();
+    tool_context_cleanup(astool);
+    return 0;
+  }
+
+  if (ctx.casec>=0) {
+    if (sufuzz_run(ctx.casev,ctx.casec,"case")<0) return 1;
+    fprintf(stderr,"sufuzz: Case passed.\n");
+    return 0;
+  }
+
+  if (sufuzz_run_random(&ctx)<0) return 1;
+  return 0;
+}
@@ -0,0 +1,364 @@
+/* sugen_main.c
+ * Batch puzzle generator.
+ * Puzzle (i) is always generated from seed (--seed+i), no matter how many threads, so output is reproducible.
+ * Workers claim chunks of puzzles from a shared counter and the main thread writes finished chunks in order.
+ * With --unique, workers also canonicalize each puzzle, and the main thread drops any whose canonical form it has already written.
+ * That catches isomorphs (relabeled, permuted, transposed) as well as exact repeats, and may leave the output short of --count.
+ *
+ * Text records, one line each:
+ *   CLUES SOLUTION SCORE TIER
+ *   CLUES is 81 characters, '.' for blanks. SOLUTION is 81 digits.
+ * Binary records, 55 bytes each:
+ *   u8[11] Clue bitmap, row-major, high bit first.
+ *   u8[41] Solution, one digit per nibble, high nibble first.
+ *   u16le  Score.
+ *   u8     Tier.
+ * --size picks another grid size from sudoku_nxn.h. Those are text only, and unrated:
+ *   CLUES SOLUTION
+ *   N*N characters each, digits past 9 are letters 'A', 'B', ...
+ */
+
+#include "tool/common/tool_context.h"
+#include "tool/common/serial.h"
+#include "common/sudoku.h"
+#include "common/sudoku_nxn.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#include <limits.h>
+
+#define SUGEN_CHUNK_SIZE 64 /* puzzles per claim */
+#define SUGEN_RECORD_LIMIT 520 /* bytes, either format, any size */
+#define SUGEN_THREAD_LIMIT 256
+
+#define SUGEN_FORMAT_TEXT 0
+#define SUGEN_FORMAT_BINARY 1
+
+struct sugen_chunk {
+  uint32_t index;
+  int ready;
+  int c;
+  int recordc;
+  uint16_t lenv[SUGEN_CHUNK_SIZE]; // Length of each record.
+  uint64_t hashv[SUGEN_CHUNK_SIZE]; // Canonical hash of each record, if (unique).
+  char v[SUGEN_CHUNK_SIZE*SUGEN_RECORD_LIMIT];
+};
+
+struct sugen_context {
+  struct tool_context hdr;
+  int count;
+  int threadc;
+  int format;
+  uint64_t seed;
+  su_count_fn backend;
+  int unique;
+  int symmetric;
+  int size; // 9, or anything else in sudoku_nxn.h
+  struct su_canon_index index;
+  int dropc;
+  pthread_mutex_t mtx;
+  pthread_cond_t cond;
+  uint32_t chunkc; // total chunks to produce
+  uint32_t nextchunk; // next to claim
+  uint32_t flushed; // chunks written so far
+  struct sugen_chunk *chunkv; // ring, chunk (i) lives at (i%chunka)
+  int chunka;
+};
+
+/* Encode one record.
+ */
+
+static int sugen_encode(char *dst,const struct sugen_context *ctx,const uint16_t *field,const struct su_rating *rating) {
+  int dstc=0,i;
+  if (ctx->format==SUGEN_FORMAT_BINARY) {
+    memset(dst,0,52);
+    for (i=0;i<81;i++) {
+      if (field[i]&0x0200) dst[i>>3]|=0x80>>(i&7);
+      uint8_t digit=(field[i]>>4)&15;
+      dst[11+(i>>1)]|=(i&1)?digit:(digit<<4);
+    }
+    dst[52]=rating->score;
+    dst[53]=rating->score>>8;
+    dst[54]=rating->tier;
+    return 55;
+  }
+  for (i=0;i<81;i++) dst[dstc++]=(field[i]&0x0200)?('0'+(field[i]&15)):'.';
+  dst[dstc++]=' ';
+  for (i=0;i<81;i++) dst[dstc++]='0'+((field[i]>>4)&15);
+  dstc+=snprintf(dst+dstc,SUGEN_RECORD_LIMIT-dstc," %d %d\n",rating->score,rating->tier);
+  return dstc;
+}
+
+/* Generate and encode one puzzle of a size other than 9.
+ */
+
+static char sugen_digit_char(uint8_t digit) {
+  if (!digit) return '.';
+  if (digit<=9) return '0'+digit;
+  return 'A'+digit-10;
+}
+
+static int sugen_encode_nxn(char *dst,const uint8_t *clues,const uint8_t *solution,int cellc) {
+  int dstc=0,i;
+  for (i=0;i<cellc;i++) dst[dstc++]=sugen_digit_char(clues[i]);
+  dst[dstc++]=' ';
+  for (i=0;i<cellc;i++) dst[dstc++]=sugen_digit_char(solution[i]);
+  dst[dstc++]='\n';
+  return dstc;
+}
+
+static int sugen_generate_nxn(char *dst,const struct sugen_context *ctx,uint64_t seed) {
+  uint8_t clues[256],solution[256];
+  #define SIZE(n,name) case n: { \
+      struct name##_generator g; \
+      name##_generator_init(&g,seed); \
+      g.symmetric=ctx->symmetric; \
+      name##_generator_generate(&g,clues,solution); \
+      return sugen_encode_nxn(dst,clues,solution,n*n); \
+    }
+  switch (ctx->size) {
+    SIZE(4,su4)
+    SIZE(6,su6)
+    SIZE(16,su16)
+  }
+  #undef SIZE
+  return 0;
+}
+
+/* Worker thread.
+ */
+
+static void *sugen_worker(void *arg) {
+  struct sugen_context *ctx=arg;
+  struct su_generator g;
+  while (1) {
+
+    pthread_mutex_lock(&ctx->mtx);
+    if (ctx->nextchunk>=ctx->chunkc) {
+      pthread_mutex_unlock(&ctx->mtx);
+      return 0;
+    }
+    uint32_t index=ctx->nextchunk++;
+    while (index>=ctx->flushed+ctx->chunka) pthread_cond_wait(&ctx->cond,&ctx->mtx);
+    struct sugen_chunk *chunk=ctx->chunkv+index%ctx->chunka;
+    pthread_mutex_unlock(&ctx->mtx);
+
+    chunk->c=0;
+    chunk->recordc=0;
+    uint32_t p=index*SUGEN_CHUNK_SIZE;
+    uint32_t end=p+SUGEN_CHUNK_SIZE;
+    if (end>ctx->count) end=ctx->count;
+    for (;p<end;p++) {
+      if (ctx->size!=9) {
+        int len=sugen_generate_nxn(chunk->v+chunk->c,ctx,ctx->seed+p);
+        chunk->c+=len;
+        chunk->lenv[chunk->recordc++]=len;
+        continue;
+      }
+      uint16_t field[81];
+      struct su_rating rating;
+      su_generator_init(&g,ctx->seed+p,ctx->backend);
+      g.symmetric=ctx->symmetric;
+      su_generator_generate(&g,field,&rating);
+      int len=sugen_encode(chunk->v+chunk->c,ctx,field,&rating);
+      chunk->c+=len;
+      chunk->lenv[chunk->recordc]=len;
+      if (ctx->unique) {
+        uint8_t canon[81];
+        su_canon_field(canon,field);
+        chunk->hashv[chunk->recordc]=su_canon_hash(canon);
+      }
+      chunk->recordc++;
+    }
+
+    pthread_mutex_lock(&ctx->mtx);
+    chunk->index=index;
+    chunk->ready=1;
+    pthread_cond_broadcast(&ctx->cond);
+    pthread_mutex_unlock(&ctx->mtx);
+  }
+}
+
+/* Run workers and write output as it becomes available.
+ */
+
+static int sugen_run(struct sugen_context *ctx,FILE *dst) {
+  ctx->chunkc=(ctx->count+SUGEN_CHUNK_SIZE-1)/SUGEN_CHUNK_SIZE;
+  ctx->chunka=ctx->threadc*4;
+  if (!(ctx->chunkv=calloc(ctx->chunka,sizeof(struct sugen_chunk)))) return -1;
+  pthread_mutex_init(&ctx->mtx,0);
+  pthread_cond_init(&ctx->cond,0);
+
+  pthread_t threadv[SUGEN_THREAD_LIMIT];
+  int threadc=0,err=0;
+  for (;threadc<ctx->threadc;threadc++) {
+    if (pthread_create(threadv+threadc,0,sugen_worker,ctx)) {
+      fprintf(stderr,"%s: Failed to create thread.\n",ctx->hdr.dstpath);
+      err=-1;
+      break;
+    }
+  }
+
+  uint32_t index=0;
+  for (;threadc&&(index<ctx->chunkc);index++) {
+    struct sugen_chunk *chunk=ctx->chunkv+index%ctx->chunka;
+    pthread_mutex_lock(&ctx->mtx);
+    while (!chunk->ready||(chunk->index!=index)) pthread_cond_wait(&ctx->cond,&ctx->mtx);
+    pthread_mutex_unlock(&ctx->mtx);
+    if (ctx->unique) {
+      const char *src=chunk->v;
+      int i=0; for (;i<chunk->recordc;src+=chunk->lenv[i],i++) {
+        int added=su_canon_index_add(&ctx->index,chunk->hashv[i]);
+        if (added<0) err=-1;
+        if (added<=0) {
+          ctx->dropc++;
+          continue;
+        }
+        if (fwrite(src,1,chunk->lenv[i],dst)!=chunk->lenv[i]) err=-1;
+      }
+    } else {
+      if (fwrite(chunk->v,1,chunk->c,dst)!=chunk->c) err=-1;
+    }
+    pthread_mutex_lock(&ctx->mtx);
+    chunk->ready=0;
+    ctx->flushed=index+1;
+    pthread_cond_broadcast(&ctx->cond);
+    pthread_mutex_unlock(&ctx->mtx);
+  }
+
+  while (threadc-->0) pthread_join(threadv[threadc],0);
+  pthread_cond_destroy(&ctx->cond);
+  pthread_mutex_destroy(&ctx->mtx);
+  free(ctx->chunkv);
+  su_canon_index_cleanup(&ctx->index);
+  return err;
+}
+
+/* Extra command-line options.
+ */
+
+static int cb_option(struct tool_context *astool,const char *k,int kc,const char *v,int vc) {
+  struct sugen_context *ctx=(struct sugen_context*)astool;
+
+  if ((kc==4)&&!memcmp(k,"help",4)) {
+    fprintf(stderr,
+      "Usage: sugen [-oOUTPUT] [--count=100] [--threads=CPUS] [--seed=TIME] [--format=text|binary] [--backend=bitboard|dlx] [--unique] [--symmetric] [--size=9]\n"
+      "Writes to stdout if OUTPUT is unset.\n"
+      "--unique drops puzzles equivalent to one already written, so output may fall short of COUNT.\n"
+      "--symmetric keeps clues rotationally symmetric about the center.\n"
+      "--size=4|6|16 makes other grid sizes, text only, unrated, and not --unique.\n"
+    );
+    return -1;
+  }
+
+  #define INTOPT(name,fld,lo,hi) if ((kc==sizeof(name)-1)&&!memcmp(k,name,kc)) { \
+    int n; \
+    if ((sr_int_eval(&n,v,vc)<2)||(n<lo)||(n>hi)) { \
+      fprintf(stderr,"sugen: Expected integer in %d..%d for '%s', found '%.*s'\n",lo,hi,name,vc,v); \
+      return -1; \
+    } \
+    ctx->fld=n; \
+    return 1; \
+  }
+  INTOPT("count",count,1,INT_MAX)
+  INTOPT("threads",threadc,1,SUGEN_THREAD_LIMIT)
+  INTOPT("size",size,4,16)
+  #undef INTOPT
+
+  if ((kc==4)&&!memcmp(k,"seed",4)) {
+    char tmp[32];
+    char *end=0;
+    if ((vc>0)&&(vc<sizeof(tmp))) {
+      memcpy(tmp,v,vc);
+      tmp[vc]=0;
+      ctx->seed=strtoull(tmp,&end,0);
+    }
+    if (!end||*end) {
+      fprintf(stderr,"sugen: Expected 64-bit integer for 'seed', found '%.*s'\n",vc,v);
+      return -1;
+    }
+    return 1;
+  }
+
+  if ((kc==6)&&!memcmp(k,"format",6)) {
+    if ((vc==4)&&!memcmp(v,"text",4)) ctx->format=SUGEN_FORMAT_TEXT;
+    else if ((vc==6)&&!memcmp(v,"binary",6)) ctx->format=SUGEN_FORMAT_BINARY;
+    else {
+      fprintf(stderr,"sugen: Unknown format '%.*s'\n",vc,v);
+      return -1;
+    }
+    return 1;
+  }
+
+  if ((kc==6)&&!memcmp(k,"unique",6)) {
+    ctx->unique=1;
+    return 1;
+  }
+
+  if ((kc==9)&&!memcmp(k,"symmetric",9)) {
+    ctx->symmetric=1;
+    return 1;
+  }
+
+  if ((kc==7)&&!memcmp(k,"backend",7)) {
+    if ((vc==8)&&!memcmp(v,"bitboard",8)) ctx->backend=su_count;
+    else if ((vc==3)&&!memcmp(v,"dlx",3)) ctx->backend=su_dlx_count;
+    else {
+      fprintf(stderr,"sugen: Unknown backend '%.*s'\n",vc,v);
+      return -1;
+    }
+    return 1;
+  }
+
+  return 0;
+}
+
+/* Main.
+ */
+
+int main(int argc,char **argv) {
+  struct sugen_context ctx={
+    .count=100,
+    .threadc=sysconf(_SC_NPROCESSORS_ONLN),
+    .format=SUGEN_FORMAT_TEXT,
+    .seed=time(0),
+    .backend=su_count,
+    .size=9,
+  };
+  struct tool_context *astool=(struct tool_context*)&ctx;
+  if (tool_context_configure(astool,argc,argv,cb_option)<0) return 1;
+  if (astool->srcpath) {
+    fprintf(stderr,"%s: Unexpected input path '%s'\n",argv[0],astool->srcpath);
+    return 1;
+  }
+  if ((ctx.size!=4)&&(ctx.size!=6)&&(ctx.size!=9)&&(ctx.size!=16)) {
+    fprintf(stderr,"%s: Unsupported size %d. Expected 4, 6, 9, or 16.\n",argv[0],ctx.size);
+    return 1;
+  }
+  if ((ctx.size!=9)&&((ctx.format!=SUGEN_FORMAT_TEXT)||ctx.unique)) {
+    fprintf(stderr,"%s: Size %d is text only, without --unique.\n",argv[0],ctx.size);
+    return 1;
+  }
+  if (ctx.threadc<1) ctx.threadc=1;
+  else if (ctx.threadc>SUGEN_THREAD_LIMIT) ctx.threadc=SUGEN_THREAD_LIMIT;
+
+  FILE *dst=stdout;
+  if (astool->dstpath&&!(dst=fopen(astool->dstpath,"wb"))) {
+    fprintf(stderr,"%s: Failed to open for writing.\n",astool->dstpath);
+    return 1;
+  }
+  fprintf(stderr,"%s: Generating %d puzzles on %d threads, seed %llu.\n",argv[0],ctx.count,ctx.threadc,(unsigned long long)ctx.seed);
+  int err=sugen_run(&ctx,dst);
+  if (dst!=stdout) fclose(dst);
+  else fflush(dst);
+  if (err<0) {
+    fprintf(stderr,"%s: Generation failed.\n",argv[0]);
+    return 1;
+  }
+  if (ctx.unique) fprintf(stderr,"%s: Dropped %d duplicate puzzles.\n",argv[0],ctx.dropc);
+  return 0;
+}
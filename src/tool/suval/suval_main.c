@@ -0,0 +1,374 @@
+/* suval_main.c
+ * Validate and rate a collection of puzzles, as fast as all our cores can go.
+ *
+ * Input is text, one puzzle per line: 81 characters, '1'..'9' for clues, '.' or '0' for blanks.
+ * Anything after the first whitespace is ignored, so our own sugen output is fine. Blank lines and '#' lines are skipped.
+ * Input streams through in fixed chunks, so memory stays bounded no matter how big the collection.
+ * The main thread reads chunks and writes them back out in order; workers claim chunks and solve them, each with its own solver.
+ *
+ * Output, one line per input puzzle, in input order:
+ *   CLUES SOLUTION SCORE TIER
+ *     Valid puzzles, in sugen's text format. So the output is ready for puzzlecvt.
+ *   # LINENO REASON: INPUT
+ *     Everything else, as comments. REASON is "malformed", "conflict", "no solution", or "multiple solutions".
+ */
+
+#include "tool/common/tool_context.h"
+#include "tool/common/decoder.h"
+#include "tool/common/serial.h"
+#include "common/sudoku.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+
+#define SUVAL_CHUNK_SIZE 256 /* lines per chunk */
+#define SUVAL_INPUT_LIMIT 100 /* bytes of each line we keep, only for echoing bad ones */
+#define SUVAL_RECORD_LIMIT 200 /* bytes per output line */
+#define SUVAL_READ_SIZE 65536
+#define SUVAL_THREAD_LIMIT 256
+
+#define SUVAL_STATUS_VALID     0
+#define SUVAL_STATUS_MALFORMED 1
+#define SUVAL_STATUS_CONFLICT  2
+#define SUVAL_STATUS_NONE      3
+#define SUVAL_STATUS_MULTIPLE  4
+#define SUVAL_STATUS_COUNT     5
+
+static const char *suval_status_namev[SUVAL_STATUS_COUNT]={
+  "valid","malformed","conflict","no solution","multiple solutions",
+};
+
+struct suval_line {
+  uint32_t lineno;
+  uint8_t textc; // Length of (text), truncated to SUVAL_INPUT_LIMIT.
+  uint8_t malformed; // Nonzero if the first word isn't 81 characters.
+  char text[SUVAL_INPUT_LIMIT];
+};
+
+struct suval_chunk {
+  uint32_t index;
+  int state; // 0=free, 1=read, 2=claimed, 3=done
+  int linec;
+  struct suval_line linev[SUVAL_CHUNK_SIZE];
+  uint32_t statusv[SUVAL_STATUS_COUNT];
+  uint32_t tierv[SU_TIER_COUNT];
+  int c;
+  char v[SUVAL_CHUNK_SIZE*SUVAL_RECORD_LIMIT];
+};
+
+struct suval_context {
+  struct tool_context hdr;
+  int threadc;
+  FILE *src;
+  char *rbuf;
+  struct decoder rdecoder; // Over (rbuf), whatever's left of the last read.
+  int eof;
+  uint32_t lineno;
+  pthread_mutex_t mtx;
+  pthread_cond_t cond;
+  struct suval_chunk *chunkv; // ring, chunk (i) lives at (i%chunka)
+  int chunka;
+  uint32_t readc; // chunks read so far
+  uint32_t nextchunk; // next for a worker to claim
+  int finished; // Nonzero once the reader is done; workers exit when nothing's left to claim.
+  uint32_t statusv[SUVAL_STATUS_COUNT];
+  uint32_t tierv[SU_TIER_COUNT];
+};
+
+/* Read one line.
+ * Returns length of (*dstpp), which includes the newline if there is one, or 0 at end of input.
+ * A line longer than our read buffer comes back in buffer-sized pieces; (*whole) is zero for all but the last.
+ */
+
+static int suval_read_line(const char **dstpp,int *whole,struct suval_context *ctx) {
+  *whole=1;
+  while (1) {
+    const char *src=(const char*)ctx->rdecoder.src+ctx->rdecoder.srcp;
+    int remaining=decoder_remaining(&ctx->rdecoder);
+    if (remaining&&(memchr(src,0x0a,remaining)||ctx->eof)) {
+      return decode_line(dstpp,&ctx->rdecoder);
+    }
+    if (ctx->eof) return 0;
+    if (remaining>=SUVAL_READ_SIZE) {
+      // No newline in a full buffer. Hand it over as a piece, the rest comes next time.
+      *whole=0;
+      ctx->rdecoder.srcp=ctx->rdecoder.srcc;
+      *dstpp=src;
+      return remaining;
+    }
+    memmove(ctx->rbuf,src,remaining);
+    int err=fread(ctx->rbuf+remaining,1,SUVAL_READ_SIZE-remaining,ctx->src);
+    if (err<=0) {
+      if (ferror(ctx->src)) return -1;
+      ctx->eof=1;
+      err=0;
+    }
+    ctx->rdecoder.src=ctx->rbuf;
+    ctx->rdecoder.srcc=remaining+err;
+    ctx->rdecoder.srcp=0;
+  }
+}
+
+/* Fill one chunk from input.
+ * Returns count of lines, 0 at end of input.
+ */
+
+static int suval_read_chunk(struct suval_context *ctx,struct suval_chunk *chunk) {
+  chunk->linec=0;
+  while (chunk->linec<SUVAL_CHUNK_SIZE) {
+    const char *src;
+    int whole;
+    int srcc=suval_read_line(&src,&whole,ctx);
+    if (srcc<0) return -1;
+    if (!srcc) break;
+    ctx->lineno++;
+    struct suval_line *line=chunk->linev+chunk->linec;
+    line->lineno=ctx->lineno;
+    line->malformed=0;
+    while (!whole) {
+      line->malformed=1;
+      if (suval_read_line(&src,&whole,ctx)<0) return -1;
+    }
+    while (srcc&&((unsigned char)src[srcc-1]<=0x20)) srcc--;
+    while (srcc&&((unsigned char)src[0]<=0x20)) { src++; srcc--; }
+    if (!srcc||(src[0]=='#')) continue;
+    int wordc=0;
+    while ((wordc<srcc)&&((unsigned char)src[wordc]>0x20)) wordc++;
+    if (wordc!=81) line->malformed=1;
+    if (srcc>SUVAL_INPUT_LIMIT) srcc=SUVAL_INPUT_LIMIT;
+    memcpy(line->text,src,srcc);
+    line->textc=srcc;
+    chunk->linec++;
+  }
+  return chunk->linec;
+}
+
+/* Validate one line into chunk's output.
+ */
+
+static uint8_t suval_validate(struct su_solver *solver,struct su_rating *rating,const struct suval_line *line) {
+  if (line->malformed) return SUVAL_STATUS_MALFORMED;
+  uint8_t clues[81];
+  uint8_t p=0; for (;p<81;p++) {
+    char ch=line->text[p];
+    if ((ch>='1')&&(ch<='9')) clues[p]=ch-'0';
+    else if ((ch=='.')||(ch=='0')) clues[p]=0;
+    else return SUVAL_STATUS_MALFORMED;
+  }
+  if (su_solver_load(solver,clues)<0) return SUVAL_STATUS_CONFLICT;
+  switch (su_solver_count(solver,2)) {
+    case 0: return SUVAL_STATUS_NONE;
+    case 1: break;
+    default: return SUVAL_STATUS_MULTIPLE;
+  }
+  su_rate(rating,clues);
+  return SUVAL_STATUS_VALID;
+}
+
+static void suval_process_chunk(struct suval_chunk *chunk,struct su_solver *solver) {
+  struct su_rating rating;
+  memset(chunk->statusv,0,sizeof(chunk->statusv));
+  memset(chunk->tierv,0,sizeof(chunk->tierv));
+  chunk->c=0;
+  const struct suval_line *line=chunk->linev;
+  int i=0; for (;i<chunk->linec;i++,line++) {
+    char *dst=chunk->v+chunk->c;
+    int dstc=0;
+    uint8_t status=suval_validate(solver,&rating,line);
+    chunk->statusv[status]++;
+    if (status==SUVAL_STATUS_VALID) {
+      chunk->tierv[rating.tier]++;
+      uint8_t p=0; for (;p<81;p++) dst[dstc++]=solver->value[p]?('0'+solver->value[p]):'.';
+      dst[dstc++]=' ';
+      for (p=0;p<81;p++) dst[dstc++]='0'+solver->solution[p];
+      dstc+=snprintf(dst+dstc,SUVAL_RECORD_LIMIT-dstc," %d %d\n",rating.score,rating.tier);
+    } else {
+      int textc=line->textc;
+      if (textc>SUVAL_RECORD_LIMIT-60) textc=SUVAL_RECORD_LIMIT-60;
+      dstc=snprintf(dst,SUVAL_RECORD_LIMIT,"# %u %s: %.*s\n",line->lineno,suval_status_namev[status],textc,line->text);
+      if (dstc>=SUVAL_RECORD_LIMIT) dstc=SUVAL_RECORD_LIMIT-1;
+    }
+    chunk->c+=dstc;
+  }
+}
+
+/* Worker thread.
+ */
+
+static void *suval_worker(void *arg) {
+  struct suval_context *ctx=arg;
+  struct su_solver solver;
+  while (1) {
+    pthread_mutex_lock(&ctx->mtx);
+    while ((ctx->nextchunk>=ctx->readc)&&!ctx->finished) pthread_cond_wait(&ctx->cond,&ctx->mtx);
+    if (ctx->nextchunk>=ctx->readc) {
+      pthread_mutex_unlock(&ctx->mtx);
+      return 0;
+    }
+    struct suval_chunk *chunk=ctx->chunkv+(ctx->nextchunk++)%ctx->chunka;
+    chunk->state=2;
+    pthread_mutex_unlock(&ctx->mtx);
+
+    suval_process_chunk(chunk,&solver);
+
+    pthread_mutex_lock(&ctx->mtx);
+    chunk->state=3;
+    pthread_cond_broadcast(&ctx->cond);
+    pthread_mutex_unlock(&ctx->mtx);
+  }
+}
+
+/* Wait for chunk (index) to finish, write it, and free its slot.
+ */
+
+static int suval_flush_chunk(struct suval_context *ctx,uint32_t index,FILE *dst) {
+  struct suval_chunk *chunk=ctx->chunkv+index%ctx->chunka;
+  pthread_mutex_lock(&ctx->mtx);
+  while (chunk->state!=3) pthread_cond_wait(&ctx->cond,&ctx->mtx);
+  pthread_mutex_unlock(&ctx->mtx);
+  int err=0;
+  if (fwrite(chunk->v,1,chunk->c,dst)!=chunk->c) err=-1;
+  int i=0; for (;i<SUVAL_STATUS_COUNT;i++) ctx->statusv[i]+=chunk->statusv[i];
+  for (i=0;i<SU_TIER_COUNT;i++) ctx->tierv[i]+=chunk->tierv[i];
+  chunk->state=0;
+  return err;
+}
+
+/* Run workers, reading and writing on this thread.
+ */
+
+static int suval_run(struct suval_context *ctx,FILE *dst) {
+  ctx->chunka=ctx->threadc*2+2;
+  if (!(ctx->chunkv=calloc(ctx->chunka,sizeof(struct suval_chunk)))) return -1;
+  if (!(ctx->rbuf=malloc(SUVAL_READ_SIZE))) return -1;
+  ctx->rdecoder.src=ctx->rbuf;
+  pthread_mutex_init(&ctx->mtx,0);
+  pthread_cond_init(&ctx->cond,0);
+
+  pthread_t threadv[SUVAL_THREAD_LIMIT];
+  int threadc=0,err=0;
+  for (;threadc<ctx->threadc;threadc++) {
+    if (pthread_create(threadv+threadc,0,suval_worker,ctx)) {
+      fprintf(stderr,"suval: Failed to create thread.\n");
+      err=-1;
+      break;
+    }
+  }
+
+  uint32_t flushed=0;
+  while (threadc&&(err>=0)) {
+    if (ctx->readc-flushed>=ctx->chunka) {
+      if (suval_flush_chunk(ctx,flushed++,dst)<0) err=-1;
+      continue;
+    }
+    struct suval_chunk *chunk=ctx->chunkv+ctx->readc%ctx->chunka;
+    int linec=suval_read_chunk(ctx,chunk);
+    if (linec<0) {
+      fprintf(stderr,"%s: Read error.\n",ctx->hdr.srcpath?ctx->hdr.srcpath:"stdin");
+      err=-1;
+      break;
+    }
+    if (!linec) break;
+    pthread_mutex_lock(&ctx->mtx);
+    chunk->index=ctx->readc++;
+    chunk->state=1;
+    pthread_cond_broadcast(&ctx->cond);
+    pthread_mutex_unlock(&ctx->mtx);
+  }
+
+  pthread_mutex_lock(&ctx->mtx);
+  ctx->finished=1;
+  pthread_cond_broadcast(&ctx->cond);
+  pthread_mutex_unlock(&ctx->mtx);
+  if (threadc) {
+    for (;flushed<ctx->readc;flushed++) {
+      if (suval_flush_chunk(ctx,flushed,dst)<0) err=-1;
+    }
+  }
+
+  while (threadc-->0) pthread_join(threadv[threadc],0);
+  pthread_cond_destroy(&ctx->cond);
+  pthread_mutex_destroy(&ctx->mtx);
+  free(ctx->chunkv);
+  free(ctx->rbuf);
+  return err;
+}
+
+/* Extra command-line options.
+ */
+
+static int cb_option(struct tool_context *astool,const char *k,int kc,const char *v,int vc) {
+  struct suval_context *ctx=(struct suval_context*)astool;
+
+  if ((kc==4)&&!memcmp(k,"help",4)) {
+    fprintf(stderr,
+      "Usage: suval [-oOUTPUT] [INPUT] [--threads=CPUS]\n"
+      "Reads stdin if INPUT is unset, and writes to stdout if OUTPUT is unset.\n"
+    );
+    return -1;
+  }
+
+  if ((kc==7)&&!memcmp(k,"threads",7)) {
+    int n;
+    if ((sr_int_eval(&n,v,vc)<2)||(n<1)||(n>SUVAL_THREAD_LIMIT)) {
+      fprintf(stderr,"suval: Expected integer in 1..%d for 'threads', found '%.*s'\n",SUVAL_THREAD_LIMIT,vc,v);
+      return -1;
+    }
+    ctx->threadc=n;
+    return 1;
+  }
+
+  return 0;
+}
+
+/* Main.
+ */
+
+int main(int argc,char **argv) {
+  struct suval_context ctx={
+    .threadc=sysconf(_SC_NPROCESSORS_ONLN),
+  };
+  struct tool_context *astool=(struct tool_context*)&ctx;
+  if (tool_context_configure(astool,argc,argv,cb_option)<0) return 1;
+  if (ctx.threadc<1) ctx.threadc=1;
+  else if (ctx.threadc>SUVAL_THREAD_LIMIT) ctx.threadc=SUVAL_THREAD_LIMIT;
+
+  ctx.src=stdin;
+  if (astool->srcpath&&!(ctx.src=fopen(astool->srcpath,"rb"))) {
+    fprintf(stderr,"%s: Failed to open for reading.\n",astool->srcpath);
+    return 1;
+  }
+  FILE *dst=stdout;
+  if (astool->dstpath&&!(dst=fopen(astool->dstpath,"wb"))) {
+    fprintf(stderr,"%s: Failed to open for writing.\n",astool->dstpath);
+    return 1;
+  }
+
+  struct timespec then,now;
+  clock_gettime(CLOCK_MONOTONIC,&then);
+  int err=suval_run(&ctx,dst);
+  clock_gettime(CLOCK_MONOTONIC,&now);
+  if (ctx.src!=stdin) fclose(ctx.src);
+  if (dst!=stdout) fclose(dst);
+  else fflush(dst);
+  if (err<0) {
+    fprintf(stderr,"%s: Validation failed.\n",argv[0]);
+    return 1;
+  }
+
+  double elapsed=(now.tv_sec-then.tv_sec)+(now.tv_nsec-then.tv_nsec)/1000000000.0;
+  uint32_t total=0;
+  int i=0; for (;i<SUVAL_STATUS_COUNT;i++) total+=ctx.statusv[i];
+  fprintf(stderr,
+    "%s: %u puzzles in %.2f s on %d threads (%.0f/s). %u valid (%u/%u/%u/%u by tier)",
+    argv[0],total,elapsed,ctx.threadc,(elapsed>0.0)?(total/elapsed):0.0,ctx.statusv[SUVAL_STATUS_VALID],
+    ctx.tierv[0],ctx.tierv[1],ctx.tierv[2],ctx.tierv[3]
+  );
+  for (i=1;i<SUVAL_STATUS_COUNT;i++) fprintf(stderr,", %u %s",ctx.statusv[i],suval_status_namev[i]);
+  fprintf(stderr,".\n");
+  return 0;
+}